@@ -0,0 +1,272 @@
+#pragma once
+
+#include "array_alloc_hook.h"
+#include "array_iterator.h"
+#include "array_policies.h"
+#include "array_stream.h"
+#include "array_trace.h"
+
+#include <assert.h>
+#include <algorithm> // std::copy
+#include <cstddef> // size_t
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// tag for the constructor that skips value-initialization
+struct Uninitialized
+{
+};
+
+// tag for the constructor that builds every element from the same arguments
+struct InPlace
+{
+};
+
+namespace detail
+{
+
+// what the copy constructor of an Array of uncopyable elements takes instead: a constructor
+// from it is not a copy constructor, so the implicit one stays deleted, as it is next to the
+// move constructor, and std::is_copy_constructible tells the truth
+struct NotCopyable
+{
+};
+
+} // namespace detail
+
+// BoundsCheck decides what operator[] does with an index (see array_policies.h), Storage
+// where the elements live
+template<typename T, typename BoundsCheck = ARRAY_DEFAULT_BOUNDS_CHECK, typename Storage = HeapStorage>
+class Array
+{
+public:
+  // (default) constructor
+  Array(const size_t size = 0)
+    : m_size(size)
+    , m_array(create(m_size, [](T* element, size_t) { new (element) T(); }))
+  {
+    if(m_array)
+      ARRAY_TRACE_EVENT(TraceOp::Create, m_size, T);
+  }
+
+  // constructor for outputs that are overwritten right away: elements are
+  // default-initialized, so trivial types are left uninitialized
+  Array(const size_t size, Uninitialized)
+    : m_size(size)
+    , m_array(create(m_size, [](T* element, size_t) { new (element) T; }))
+  {
+    if(m_array)
+      ARRAY_TRACE_EVENT(TraceOp::Create, m_size, T);
+  }
+
+  // every element is constructed as T(args...), so T needs neither a default
+  // constructor nor copy assignment
+  template<typename... Args>
+  Array(const size_t size, InPlace, const Args&... args)
+    : m_size(size)
+    , m_array(create(m_size, [&](T* element, size_t) { new (element) T(args...); }))
+  {
+    if(m_array)
+      ARRAY_TRACE_EVENT(TraceOp::Create, m_size, T);
+  }
+
+//  // unsafe version: the old elements are freed before the new ones exist, so if new or an
+//  // element assignment throws, *this is left with a dangling m_array and the wrong m_size,
+//  // and its destructor deletes the block a second time
+//  Array& operator=(const Array& other)
+//  {
+//    if(&other != this)
+//    {
+//      delete [] m_array;
+//      m_size = other.m_size;
+//      m_array = new T[m_size];
+//      std::copy(other.m_array, other.m_array + m_size, m_array);
+//    }
+//    return *this;
+//  }
+
+  // safe version, copy-and-swap: everything that can throw happens while the parameter is
+  // copied, before *this is touched, and the swap cannot throw, so a failed assignment leaves
+  // *this as it was. Also the move assignment, the parameter is then move-constructed and no
+  // element is created
+  Array& operator=(Array other) noexcept
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  // move constructor
+  Array(Array&& other) noexcept
+    : m_size(other.m_size)
+    , m_array(other.m_array)
+  {
+    other.m_size = 0;
+    other.m_array = nullptr;
+  }
+
+  // copy-constructor, only for copyable T: Arrays of move-only elements are move-only
+  Array(const typename std::conditional<std::is_copy_constructible<T>::value, Array, detail::NotCopyable>::type& other)
+    : m_size(other.m_size)
+    , m_array(copyOf(other.m_array, m_size, CopyByAssignment()))
+  {
+    if(m_array)
+      ARRAY_TRACE_EVENT(TraceOp::Copy, m_size, T);
+  }
+
+  // destructor
+  ~Array()
+  {
+    if(m_array)
+      ARRAY_TRACE_EVENT(TraceOp::Destroy, m_size, T);
+
+    destroy(m_array, m_size);
+  }
+
+  void swap(Array& first, Array& second) // nothrow
+  {
+    std::swap(first.m_size, second.m_size);
+    std::swap(first.m_array, second.m_array);
+  }
+
+  const size_t size() const
+  {
+    return m_size;
+  }
+
+  T& operator [](const size_t index)
+  {
+    BoundsCheck::check(index, m_size);
+
+    return m_array[index];
+  }
+
+  const T& operator [](const size_t index) const
+  {
+    BoundsCheck::check(index, m_size);
+
+    return m_array[index];
+  }
+
+  // assigns 'value' to every element, past the cache for big trivially copyable Arrays
+  void fill(const T& value)
+  {
+    streamingFill(m_array, m_size, value);
+  }
+
+  // raw access for the bulk kernels, no bounds checks
+  T* data()
+  {
+    return m_array;
+  }
+
+  const T* data() const
+  {
+    return m_array;
+  }
+
+  // pointers, or CheckedIterators when the BoundsCheck policy asks for them (see
+  // array_iterator.h)
+  typedef typename detail::ArrayIterator<T, BoundsCheck>::type iterator;
+  typedef typename detail::ArrayIterator<const T, BoundsCheck>::type const_iterator;
+
+  iterator begin()
+  {
+    return detail::ArrayIterator<T, BoundsCheck>::make(m_array, m_array, m_array + m_size);
+  }
+
+  iterator end()
+  {
+    return detail::ArrayIterator<T, BoundsCheck>::make(m_array + m_size, m_array, m_array + m_size);
+  }
+
+  const_iterator begin() const
+  {
+    return detail::ArrayIterator<const T, BoundsCheck>::make(m_array, m_array, m_array + m_size);
+  }
+
+  const_iterator end() const
+  {
+    return detail::ArrayIterator<const T, BoundsCheck>::make(m_array + m_size, m_array, m_array + m_size);
+  }
+
+private:
+  // the copy has always been default construction followed by assignment; elements
+  // without a default constructor or copy assignment are copy-constructed instead
+  typedef std::integral_constant<bool, std::is_default_constructible<T>::value
+                                       && std::is_copy_assignable<T>::value> CopyByAssignment;
+
+  static T* copyOf(const T* source, const size_t size, std::true_type)
+  {
+    T* array = create(size, [](T* element, size_t) { new (element) T; });
+
+    // plain std::copy: memcpy already streams copies this big past the cache, faster than
+    // streamingCopy, which stays for callers that want it regardless of the libc
+    try
+    {
+      std::copy(source, source + size, array);
+    }
+    catch(...)
+    {
+      destroy(array, size);
+      throw;
+    }
+
+    return array;
+  }
+
+  static T* copyOf(const T* source, const size_t size, std::false_type)
+  {
+    return create(size, [source](T* element, const size_t index) { new (element) T(source[index]); });
+  }
+
+  // allocates room for 'size' elements and runs construct(element, index) on each of
+  // them; if one throws, the ones already built are destroyed and the memory freed
+  template<typename Construct>
+  static T* create(const size_t size, Construct construct)
+  {
+    if(!size)
+      return nullptr;
+
+    if(size > size_t(-1) / sizeof(T))
+      throw std::bad_array_new_length();
+
+    T* array = static_cast<T*>(Storage::template allocate<T>(size * sizeof(T)));
+    ARRAY_SAMPLE_ALLOCATION(size * sizeof(T));
+    size_t constructed = 0;
+
+    try
+    {
+      for(; constructed < size; ++constructed)
+        construct(array + constructed, constructed);
+    }
+    catch(...)
+    {
+      destroyElements(array, constructed);
+      Storage::template deallocate<T>(array, size * sizeof(T));
+      throw;
+    }
+
+    return array;
+  }
+
+  static void destroy(T* array, const size_t size) noexcept
+  {
+    if(!array)
+      return;
+
+    destroyElements(array, size);
+    Storage::template deallocate<T>(array, size * sizeof(T));
+  }
+
+  static void destroyElements(T* array, const size_t count) noexcept
+  {
+    if(!std::is_trivially_destructible<T>::value)
+      for(size_t i = count; i; --i)
+        array[i - 1].~T();
+  }
+
+  size_t m_size;
+  T* m_array;
+  //std::unique_ptr<T[]> m_array;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint>
+
+#if defined(__GNUC__)
+#define ARRAY_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define ARRAY_NOINLINE __declspec(noinline)
+#else
+#define ARRAY_NOINLINE
+#endif
+
+// build with -DARRAY_ALLOCATION_PROFILER=0 to drop the sampling hook from Array altogether;
+// compiled in it costs a thread-local subtraction per allocation, and while no profiler runs a
+// reset of the countdown every ALLOCATION_SAMPLE_INTERVAL bytes
+#ifndef ARRAY_ALLOCATION_PROFILER
+#define ARRAY_ALLOCATION_PROFILER 1
+#endif
+
+#if ARRAY_ALLOCATION_PROFILER
+#define ARRAY_SAMPLE_ALLOCATION(bytes) AllocationHook::allocated(bytes)
+#else
+#define ARRAY_SAMPLE_ALLOCATION(bytes) ((void)0)
+#endif
+
+// mean number of bytes between two samples by default
+const size_t ALLOCATION_SAMPLE_INTERVAL = 512 << 10;
+
+namespace detail
+{
+
+// takes a sample of an allocation of 'bytes' and rearms the countdown; must not throw
+typedef void (*AllocationSampler)(size_t bytes);
+
+} // namespace detail
+
+// the part of the allocation profiler that Array calls into: a per-thread countdown of bytes
+// and, once it runs out, the sampler AllocationProfiler::start() installed
+// (array_alloc_profile.h). Without one the countdown is only reset, so the stack walking and
+// symbol lookup stay out of the translation units that merely use Array
+class AllocationHook
+{
+public:
+  // fast path of the hook in Array::create; never throws, so it cannot leak the block that
+  // was just allocated
+  static void allocated(const size_t bytes) noexcept
+  {
+    int64_t& untilSample = bytesUntilSample();
+    untilSample -= static_cast<int64_t>(bytes);
+    if(untilSample < 0)
+      sample(bytes);
+  }
+
+  // 'sampler' takes over the slow path, nullptr gives it back
+  static void install(const detail::AllocationSampler sampler) noexcept
+  {
+    samplerSlot().store(sampler, std::memory_order_release);
+  }
+
+  static int64_t& bytesUntilSample() noexcept
+  {
+    static thread_local int64_t bytes = ALLOCATION_SAMPLE_INTERVAL;
+    return bytes;
+  }
+
+private:
+  static std::atomic<detail::AllocationSampler>& samplerSlot() noexcept
+  {
+    static std::atomic<detail::AllocationSampler> sampler(nullptr);
+    return sampler;
+  }
+
+  // the slow path, at most about once per interval; kept out of line so that the sampler's
+  // backtrace starts at a known depth
+  ARRAY_NOINLINE static void sample(const size_t bytes) noexcept
+  {
+    const detail::AllocationSampler sampler = samplerSlot().load(std::memory_order_acquire);
+    if(sampler)
+      sampler(bytes);
+    else
+      bytesUntilSample() = ALLOCATION_SAMPLE_INTERVAL;
+  }
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "array_alloc_hook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#define ARRAY_HAS_BACKTRACE 1
+#endif
+
+// sampling profiler of the Array allocations: once started, every thread takes a stack trace
+// about every 'interval' allocated bytes (the distance is drawn from an exponential
+// distribution so that periodic allocation patterns do not alias) and the samples are
+// aggregated by call stack. Each sample is weighted by the bytes it stands for, so the report
+// estimates the bytes allocated at each site, in the collapsed-stack format of flamegraph.pl.
+// Frames are named through the dynamic symbol table: link with -rdynamic (ENABLE_EXPORTS in
+// CMake) to see the functions of the executable itself. Array only carries the countdown of
+// AllocationHook (array_alloc_hook.h); this header is needed where the profiler is driven
+class AllocationProfiler
+{
+public:
+  static void start(const size_t interval = ALLOCATION_SAMPLE_INTERVAL)
+  {
+    State& state = instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.sites.clear();
+    state.interval.store(interval ? interval : 1, std::memory_order_relaxed);
+    state.generation.fetch_add(1, std::memory_order_release);
+    AllocationHook::install(&sample);
+  }
+
+  static void stop()
+  {
+    AllocationHook::install(nullptr);
+    instance().interval.store(0, std::memory_order_relaxed);
+  }
+
+  // estimated bytes and sample count of every call stack sampled since start(), heaviest
+  // first; the frames go from the outermost call to the allocating function
+  struct Site
+  {
+    std::vector<std::string> frames;
+    double bytes;
+    size_t samples;
+  };
+
+  static std::vector<Site> sites()
+  {
+    State& state = instance();
+    std::vector<Site> result;
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      for(std::map<Stack, Totals>::const_iterator s = state.sites.begin(); s != state.sites.end(); ++s)
+      {
+        Site site;
+        site.bytes = s->second.bytes;
+        site.samples = s->second.samples;
+        for(size_t f = s->first.size(); f; --f)
+          site.frames.push_back(symbolName(s->first[f - 1]));
+        result.push_back(site);
+      }
+    }
+
+    std::sort(result.begin(), result.end(), [](const Site& a, const Site& b) { return a.bytes > b.bytes; });
+    return result;
+  }
+
+  // "outer;...;inner bytes" lines for flamegraph.pl, heaviest first; returns the line count
+  static size_t writeCollapsed(std::ostream& out)
+  {
+    const std::vector<Site> all = sites();
+    for(size_t s = 0; s < all.size(); ++s)
+    {
+      for(size_t f = 0; f < all[s].frames.size(); ++f)
+        out << (f ? ";" : "") << all[s].frames[f];
+      if(all[s].frames.empty())
+        out << "[unknown]";
+      out << " " << static_cast<uint64_t>(all[s].bytes + 0.5) << "\n";
+    }
+    return all.size();
+  }
+
+private:
+  typedef std::vector<void*> Stack;
+
+  struct Totals
+  {
+    double bytes;
+    size_t samples;
+  };
+
+  struct State
+  {
+    State()
+      : interval(0)
+      , generation(0)
+    {
+    }
+
+    std::atomic<size_t> interval;
+    std::atomic<unsigned> generation;
+    std::mutex mutex;
+    std::map<Stack, Totals> sites;
+  };
+
+  // never destroyed, like the tracer state: Arrays are allocated by static constructors too
+  static State& instance()
+  {
+    static State* state = new State;
+    return *state;
+  }
+
+  // the sampler installed while the profiler runs. A sample that cannot be taken (no memory
+  // for the stack or the site, no random device) is dropped
+  ARRAY_NOINLINE static void sample(const size_t bytes) noexcept
+  {
+    try
+    {
+      record(bytes);
+    }
+    catch(...)
+    {
+      AllocationHook::bytesUntilSample() = ALLOCATION_SAMPLE_INTERVAL;
+    }
+  }
+
+  ARRAY_NOINLINE static void record(const size_t bytes)
+  {
+    State& state = instance();
+    const size_t interval = state.interval.load(std::memory_order_relaxed);
+
+    // stopped after this thread found the sampler
+    if(!interval)
+    {
+      AllocationHook::bytesUntilSample() = ALLOCATION_SAMPLE_INTERVAL;
+      return;
+    }
+
+    static thread_local std::mt19937_64 random(std::random_device{}());
+    static thread_local unsigned seenGeneration = 0;
+    const unsigned generation = state.generation.load(std::memory_order_acquire);
+
+    AllocationHook::bytesUntilSample()
+      = static_cast<int64_t>(std::exponential_distribution<double>(1.0 / interval)(random)) + 1;
+
+    // the countdown ran under the interval of an earlier start(), or under none
+    if(seenGeneration != generation)
+    {
+      seenGeneration = generation;
+      return;
+    }
+
+    // an allocation of 'bytes' is sampled with probability 1 - exp(-bytes / interval), so it
+    // stands for bytes / that probability
+    const double weight = bytes / (1 - std::exp(-static_cast<double>(bytes) / interval));
+
+    Stack stack;
+#ifdef ARRAY_HAS_BACKTRACE
+    void* frames[64];
+    const int depth = backtrace(frames, 64);
+    // frames 0 to 2 are this function, sample() and AllocationHook::sample()
+    if(depth > 3)
+      stack.assign(frames + 3, frames + depth);
+#endif
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    Totals& totals = state.sites.insert(std::make_pair(stack, Totals())).first->second;
+    totals.bytes += weight;
+    ++totals.samples;
+  }
+
+  static std::string symbolName(void* address)
+  {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%p", address);
+    std::string name = text;
+
+#ifdef ARRAY_HAS_BACKTRACE
+    Dl_info info;
+    if(!dladdr(address, &info))
+      info.dli_sname = info.dli_fname = nullptr;
+
+    if(info.dli_sname)
+    {
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      name = demangled ? demangled : info.dli_sname;
+      std::free(demangled);
+    }
+    else if(info.dli_fname)
+    {
+      const std::string module = info.dli_fname;
+      std::snprintf(text, sizeof(text), "+%#lx", static_cast<unsigned long>(
+        static_cast<char*>(address) - static_cast<char*>(info.dli_fbase)));
+      name = module.substr(module.rfind('/') + 1) + text;
+    }
+#endif
+
+    // ';' separates the frames of a collapsed stack
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+  }
+};
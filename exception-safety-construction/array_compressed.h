@@ -0,0 +1,450 @@
+#pragma once
+
+#include "array.h"
+#include "array_intrinsics.h" // detail::lowestBit
+#include "array_view.h"
+#include "parallel.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// uncompressed bytes per block, and blocks kept decompressed by default
+const size_t COMPRESSED_BLOCK_BYTES = 64 << 10;
+const size_t COMPRESSED_CACHE_BLOCKS = 4;
+
+namespace detail
+{
+
+// byte-shuffle: byte b of element i goes to b * count + i, so the bytes that vary little from
+// one element to the next (the high bytes of small integers, the exponents of doubles) end up
+// next to each other where the run-length coder finds them. The element width is a template
+// argument so that the inner loop is unrolled
+template<size_t Width>
+void shuffleScalar(const unsigned char* in, unsigned char* out, const size_t begin, const size_t count)
+{
+  for(size_t i = begin; i < count; ++i)
+    for(size_t b = 0; b < Width; ++b)
+      out[b * count + i] = in[i * Width + b];
+}
+
+template<size_t Width>
+void unshuffleScalar(const unsigned char* in, unsigned char* out, const size_t begin, const size_t count)
+{
+  for(size_t i = begin; i < count; ++i)
+    for(size_t b = 0; b < Width; ++b)
+      out[i * Width + b] = in[b * count + i];
+}
+
+// widths the SSE2 byte transpose handles: powers of two up to a register
+template<size_t Width>
+struct IsTransposable
+#if defined(__SSE2__)
+  : std::integral_constant<bool, Width >= 2 && Width <= 16 && !(Width & (Width - 1))>
+#else
+  : std::false_type
+#endif
+{
+};
+
+#if defined(__SSE2__)
+// 16 elements of Width bytes sit in Width registers, byte p of the group at bit positions
+// [element, byte]. One round interleaves register k with register k + Width / 2 byte by byte,
+// which rotates that position index left by one bit; four rounds turn the bytes of the 16
+// elements into Width planes of 16 bytes, the remaining log2(Width) rounds turn them back
+template<size_t Width>
+inline void transposeRound(__m128i* x)
+{
+  __m128i y[Width];
+  for(size_t k = 0; k < Width / 2; ++k)
+  {
+    y[2 * k] = _mm_unpacklo_epi8(x[k], x[k + Width / 2]);
+    y[2 * k + 1] = _mm_unpackhi_epi8(x[k], x[k + Width / 2]);
+  }
+
+  for(size_t k = 0; k < Width; ++k)
+    x[k] = y[k];
+}
+
+template<size_t Width>
+void shuffleBytes(const unsigned char* in, unsigned char* out, const size_t count, std::true_type)
+{
+  const size_t groups = count / 16;
+  for(size_t g = 0; g < groups; ++g)
+  {
+    __m128i x[Width];
+    for(size_t k = 0; k < Width; ++k)
+      x[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + (g * Width + k) * 16));
+
+    for(size_t round = 0; round < 4; ++round)
+      transposeRound<Width>(x);
+
+    for(size_t b = 0; b < Width; ++b)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * count + g * 16), x[b]);
+  }
+
+  shuffleScalar<Width>(in, out, groups * 16, count);
+}
+
+template<size_t Width>
+void unshuffleBytes(const unsigned char* in, unsigned char* out, const size_t count, std::true_type)
+{
+  const size_t groups = count / 16;
+  for(size_t g = 0; g < groups; ++g)
+  {
+    __m128i x[Width];
+    for(size_t b = 0; b < Width; ++b)
+      x[b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * count + g * 16));
+
+    for(size_t bit = 1; bit < Width; bit *= 2)
+      transposeRound<Width>(x);
+
+    for(size_t k = 0; k < Width; ++k)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (g * Width + k) * 16), x[k]);
+  }
+
+  unshuffleScalar<Width>(in, out, groups * 16, count);
+}
+#endif
+
+template<size_t Width>
+void shuffleBytes(const unsigned char* in, unsigned char* out, const size_t count, std::false_type)
+{
+  shuffleScalar<Width>(in, out, 0, count);
+}
+
+template<size_t Width>
+void unshuffleBytes(const unsigned char* in, unsigned char* out, const size_t count, std::false_type)
+{
+  unshuffleScalar<Width>(in, out, 0, count);
+}
+
+template<size_t Width>
+void shuffleBytes(const unsigned char* in, unsigned char* out, const size_t count)
+{
+  shuffleBytes<Width>(in, out, count, typename IsTransposable<Width>::type());
+}
+
+template<size_t Width>
+void unshuffleBytes(const unsigned char* in, unsigned char* out, const size_t count)
+{
+  unshuffleBytes<Width>(in, out, count, typename IsTransposable<Width>::type());
+}
+
+// most bytes rleEncode can write for 'size' input bytes
+inline size_t rleBound(const size_t size)
+{
+  return size + (size + 127) / 128;
+}
+
+// bytes rleDecode may read past the end of its input and write past the end of its output:
+// packets are copied in whole 16-byte pieces
+const size_t RLE_SLACK = 16;
+
+// run-length coding with one control byte per packet: 0..127 is followed by that many plus
+// one literal bytes, 129..255 by one byte repeated (control - 126) times (3..129). Literals
+// only give way to runs of four or more, a shorter run in their middle would save nothing
+// and cost a packet
+inline size_t rleEncode(const unsigned char* in, const size_t size, unsigned char* out)
+{
+  size_t i = 0;
+  size_t o = 0;
+
+  while(i < size)
+  {
+    size_t run = 1;
+#if defined(__SSE2__)
+    // 16 bytes at a time against the first byte of the run
+    const __m128i first = _mm_set1_epi8(static_cast<char>(in[i]));
+    while(i + run + 16 <= size && run + 16 <= 129)
+    {
+      const unsigned equal = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + run)), first));
+      if(equal != 0xFFFF)
+      {
+        run += lowestBit(~equal);
+        break;
+      }
+      run += 16;
+    }
+#endif
+    while(i + run < size && run < 129 && in[i + run] == in[i])
+      ++run;
+
+    if(run >= 3)
+    {
+      out[o++] = static_cast<unsigned char>(126 + run);
+      out[o++] = in[i];
+      i += run;
+      continue;
+    }
+
+    const size_t start = i;
+#if defined(__SSE2__)
+    // bit j of 'equal' is set when byte i + j equals the next one, three set bits in a row
+    // start a run of four
+    while(i + 17 <= size && i - start + 14 <= 128)
+    {
+      const unsigned equal = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 1))));
+      const unsigned runs = equal & (equal >> 1) & (equal >> 2) & 0x3FFF;
+      if(runs)
+      {
+        i += lowestBit(runs);
+        break;
+      }
+      i += 14;
+    }
+#endif
+    while(i < size && i - start < 128
+          && !(i + 3 < size && in[i] == in[i + 1] && in[i] == in[i + 2] && in[i] == in[i + 3]))
+      ++i;
+
+    out[o++] = static_cast<unsigned char>(i - start - 1);
+    std::memcpy(out + o, in + start, i - start);
+    o += i - start;
+  }
+
+  return o;
+}
+
+inline void rleDecode(const unsigned char* in, const size_t size, unsigned char* out, const size_t outSize)
+{
+  const unsigned char* const end = in + size;
+  unsigned char* const outEnd = out + outSize;
+
+  while(in < end)
+  {
+    const unsigned control = *in++;
+    if(control < 128)
+    {
+      const size_t length = control + 1;
+      for(size_t copied = 0; copied < length; copied += RLE_SLACK)
+        std::memcpy(out + copied, in + copied, RLE_SLACK);
+      in += length;
+      out += length;
+    }
+    else
+    {
+      const size_t length = control - 126;
+      for(size_t filled = 0; filled < length; filled += RLE_SLACK)
+        std::memset(out + filled, *in, RLE_SLACK);
+      ++in;
+      out += length;
+    }
+  }
+
+  assert(out == outEnd);
+  (void)outEnd;
+}
+
+} // namespace detail
+
+// read-mostly copy of an Array kept compressed in memory: the elements are cut into blocks of
+// COMPRESSED_BLOCK_BYTES, each byte-shuffled and run-length coded on its own (or kept as is
+// when that does not make it smaller), and reads decompress the block they need into a small
+// least-recently-used cache. Reading goes through that cache, so a CompressedArray must not be
+// read from several threads at once
+template<typename T>
+class CompressedArray
+{
+  static_assert(std::is_trivially_copyable<T>::value, "CompressedArray stores the bytes of its elements");
+  static_assert(sizeof(T) <= COMPRESSED_BLOCK_BYTES, "CompressedArray needs at least one element per block");
+
+public:
+  static const size_t BLOCK_ELEMENTS = COMPRESSED_BLOCK_BYTES / sizeof(T);
+
+  CompressedArray()
+    : m_size(0)
+    , m_clock(0)
+    , m_misses(0)
+  {
+  }
+
+  // compresses the blocks in parallel
+  explicit CompressedArray(const ArrayView<const T> values, const size_t cacheBlocks = COMPRESSED_CACHE_BLOCKS)
+    : m_size(values.size())
+    , m_offsets((m_size + BLOCK_ELEMENTS - 1) / BLOCK_ELEMENTS + 1)
+    , m_cache(cacheBlocks ? cacheBlocks : 1)
+    , m_clock(0)
+    , m_misses(0)
+  {
+    const size_t blocks = m_offsets.size() - 1;
+    const size_t bound = detail::rleBound(COMPRESSED_BLOCK_BYTES);
+    Array<unsigned char> scratch(blocks * bound, Uninitialized());
+    Array<size_t> sizes(blocks, Uninitialized());
+
+    parallelFor(blocks, parallelThreadCount(blocks, 1), [&](size_t, const size_t begin, const size_t end)
+    {
+      Array<unsigned char> shuffled(COMPRESSED_BLOCK_BYTES, Uninitialized());
+      for(size_t block = begin; block < end; ++block)
+        sizes[block] = compressBlock(values.data() + block * BLOCK_ELEMENTS, elementsIn(block),
+                                     shuffled.data(), scratch.data() + block * bound);
+    });
+
+    for(size_t block = 0; block < blocks; ++block)
+      m_offsets[block + 1] = m_offsets[block] + sizes[block];
+
+    // the decoder may read RLE_SLACK bytes past the last block
+    m_bytes = Array<unsigned char>(m_offsets[blocks] + detail::RLE_SLACK, Uninitialized());
+    for(size_t block = 0; block < blocks; ++block)
+      std::memcpy(m_bytes.data() + m_offsets[block], scratch.data() + block * bound, sizes[block]);
+  }
+
+  const size_t size() const
+  {
+    return m_size;
+  }
+
+  size_t blocks() const
+  {
+    return m_offsets.size() ? m_offsets.size() - 1 : 0;
+  }
+
+  // bytes of the compressed blocks
+  size_t compressedBytes() const
+  {
+    return m_offsets.size() ? m_offsets[m_offsets.size() - 1] : 0;
+  }
+
+  // element 'index', by value: a later read may evict the block it came from
+  T operator [](const size_t index) const
+  {
+    assert(index < m_size);
+    return block(index / BLOCK_ELEMENTS)[index % BLOCK_ELEMENTS];
+  }
+
+  // copies 'count' elements from 'first' on to 'out'
+  void read(const size_t first, const size_t count, T* out) const
+  {
+    assert(first + count <= m_size);
+
+    for(size_t done = 0; done < count; )
+    {
+      const size_t index = first + done;
+      const size_t offset = index % BLOCK_ELEMENTS;
+      const size_t n = std::min(count - done, BLOCK_ELEMENTS - offset);
+      const T* values = block(index / BLOCK_ELEMENTS) + offset;
+      std::copy(values, values + n, out + done);
+      done += n;
+    }
+  }
+
+  // all elements, uncompressed; bypasses the cache
+  Array<T> decompress() const
+  {
+    Array<T> values(m_size, Uninitialized());
+    Array<unsigned char> shuffled(COMPRESSED_BLOCK_BYTES + detail::RLE_SLACK, Uninitialized());
+
+    for(size_t block = 0; block < blocks(); ++block)
+      decompressBlock(block, shuffled.data(), values.data() + block * BLOCK_ELEMENTS);
+
+    return values;
+  }
+
+  // blocks decompressed by reads so far
+  size_t cacheMisses() const
+  {
+    return m_misses;
+  }
+
+private:
+  struct CachedBlock
+  {
+    CachedBlock()
+      : block(size_t(-1))
+      , lastUse(0)
+    {
+    }
+
+    size_t block;
+    uint64_t lastUse;
+    Array<T> values;
+  };
+
+  size_t elementsIn(const size_t block) const
+  {
+    return std::min(BLOCK_ELEMENTS, m_size - block * BLOCK_ELEMENTS);
+  }
+
+  // returns the bytes written to 'out'; a block that does not shrink is stored raw, which
+  // decompressBlock tells from its size
+  static size_t compressBlock(const T* values, const size_t count, unsigned char* shuffled, unsigned char* out)
+  {
+    const size_t bytes = count * sizeof(T);
+    detail::shuffleBytes<sizeof(T)>(reinterpret_cast<const unsigned char*>(values), shuffled, count);
+
+    const size_t encoded = detail::rleEncode(shuffled, bytes, out);
+    if(encoded < bytes)
+      return encoded;
+
+    std::memcpy(out, values, bytes);
+    return bytes;
+  }
+
+  void decompressBlock(const size_t block, unsigned char* shuffled, T* out) const
+  {
+    const size_t count = elementsIn(block);
+    const size_t bytes = count * sizeof(T);
+    const unsigned char* in = m_bytes.data() + m_offsets[block];
+    const size_t stored = m_offsets[block + 1] - m_offsets[block];
+
+    if(stored == bytes)
+    {
+      std::memcpy(out, in, bytes);
+      return;
+    }
+
+    detail::rleDecode(in, stored, shuffled, bytes);
+    detail::unshuffleBytes<sizeof(T)>(shuffled, reinterpret_cast<unsigned char*>(out), count);
+  }
+
+  // the elements of 'block', from the cache or decompressed into its least recently used slot
+  const T* block(const size_t block) const
+  {
+    CachedBlock* victim = &m_cache[0];
+    for(size_t slot = 0; slot < m_cache.size(); ++slot)
+    {
+      CachedBlock& cached = m_cache[slot];
+      if(cached.block == block)
+      {
+        cached.lastUse = ++m_clock;
+        return cached.values.data();
+      }
+
+      if(cached.lastUse < victim->lastUse)
+        victim = &cached;
+    }
+
+    // slots and the shuffle buffer are allocated on first use
+    if(!victim->values.size())
+      victim->values = Array<T>(BLOCK_ELEMENTS, Uninitialized());
+    if(!m_shuffled.size())
+      m_shuffled = Array<unsigned char>(COMPRESSED_BLOCK_BYTES + detail::RLE_SLACK, Uninitialized());
+
+    decompressBlock(block, m_shuffled.data(), victim->values.data());
+    victim->block = block;
+    victim->lastUse = ++m_clock;
+    ++m_misses;
+    return victim->values.data();
+  }
+
+  size_t m_size;
+  Array<size_t> m_offsets;
+  Array<unsigned char> m_bytes;
+
+  mutable Array<CachedBlock> m_cache;
+  mutable Array<unsigned char> m_shuffled;
+  mutable uint64_t m_clock;
+  mutable size_t m_misses;
+};
+
+template<typename T>
+const size_t CompressedArray<T>::BLOCK_ELEMENTS;
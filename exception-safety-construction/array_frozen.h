@@ -0,0 +1,112 @@
+#pragma once
+
+#include "array.h"
+#include "array_hash.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+// immutable, shared Array: copies of a FrozenArray share one HashedArray, so handing it to
+// another thread costs a reference count increment instead of an element copy. Nothing can
+// modify the elements after freeze(), which makes concurrent reads safe without any locking;
+// the size and the content hash are computed once when freezing
+template<typename T>
+class FrozenArray
+{
+public:
+  FrozenArray()
+  {
+  }
+
+  const size_t size() const
+  {
+    return m_array ? m_array->size() : 0;
+  }
+
+  uint64_t hash() const
+  {
+    return m_array ? m_array->hash() : hashArray(Array<T>());
+  }
+
+  const T& operator [](const size_t index) const
+  {
+    return (*m_array)[index];
+  }
+
+  const T* data() const
+  {
+    return m_array ? m_array->array().data() : nullptr;
+  }
+
+  const T* begin() const
+  {
+    return data();
+  }
+
+  const T* end() const
+  {
+    return data() + size();
+  }
+
+  // mutable copy of the elements
+  Array<T> thaw() const
+  {
+    return m_array ? m_array->array() : Array<T>();
+  }
+
+  // true when both share the same elements
+  bool shares(const FrozenArray& other) const
+  {
+    return m_array == other.m_array;
+  }
+
+  bool operator ==(const FrozenArray& other) const
+  {
+    if(shares(other))
+      return true;
+    if(size() != other.size() || hash() != other.hash())
+      return false;
+
+    return !size() || m_array->array() == other.m_array->array();
+  }
+
+  bool operator !=(const FrozenArray& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  template<typename U>
+  friend FrozenArray<U> freeze(Array<U> array);
+
+  explicit FrozenArray(std::shared_ptr<const HashedArray<T> > array)
+    : m_array(std::move(array))
+  {
+  }
+
+  std::shared_ptr<const HashedArray<T> > m_array;
+};
+
+// takes the elements over without copying them when 'array' is passed as an rvalue; the one
+// allocation holds the reference counts and the HashedArray
+template<typename T>
+FrozenArray<T> freeze(Array<T> array)
+{
+  return FrozenArray<T>(std::make_shared<const HashedArray<T> >(std::move(array)));
+}
+
+namespace std
+{
+
+template<typename T>
+struct hash<FrozenArray<T> >
+{
+  size_t operator ()(const FrozenArray<T>& array) const
+  {
+    return static_cast<size_t>(array.hash());
+  }
+};
+
+} // namespace std
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "array.h"
+#include "array_intrinsics.h" // detail::hashMix
+#include "array_small.h" // IsBitwiseComparable
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring> // std::memcmp, std::memcpy
+#include <functional> // std::hash
+#include <type_traits>
+#include <utility> // std::move
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace detail
+{
+
+const size_t HASH_STRIPE = 32;
+const size_t HASH_STRIPES_PER_BLOCK = 16;
+const uint64_t HASH_PRIME_32 = 0x9E3779B1ull;
+
+// per-lane keys xor'ed into the input before the multiply
+const uint64_t HASH_KEYS[4] =
+{
+  0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull
+};
+
+// one 32-byte stripe into four 64-bit accumulators: every lane adds the 32x32->64 product of the
+// keyed input halves, plus the raw input of its neighbour lane so no input bit is lost
+inline void hashStripe(uint64_t* accumulators, const unsigned char* stripe)
+{
+#if defined(__AVX2__)
+  const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stripe));
+  const __m256i keyed = _mm256_xor_si256(data, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(HASH_KEYS)));
+  const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+  const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+  __m256i accumulator = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulators));
+  accumulator = _mm256_add_epi64(accumulator, _mm256_add_epi64(product, swapped));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulators), accumulator);
+#elif defined(__SSE2__)
+  for(size_t half = 0; half < 4; half += 2)
+  {
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stripe + half * 8));
+    const __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(HASH_KEYS + half)));
+    const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+    const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i accumulator = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulators + half));
+    accumulator = _mm_add_epi64(accumulator, _mm_add_epi64(product, swapped));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulators + half), accumulator);
+  }
+#else
+  uint64_t data[4];
+  std::memcpy(data, stripe, sizeof(data));
+  for(size_t lane = 0; lane < 4; ++lane)
+  {
+    const uint64_t keyed = data[lane] ^ HASH_KEYS[lane];
+    accumulators[lane] += (keyed & 0xffffffffull) * (keyed >> 32) + data[lane ^ 1];
+  }
+#endif
+}
+
+// folds the high bits back in between blocks so products cannot drift into the top bits only
+inline void hashScramble(uint64_t* accumulators)
+{
+  for(size_t lane = 0; lane < 4; ++lane)
+  {
+    uint64_t value = accumulators[lane];
+    value ^= value >> 47;
+    value ^= HASH_KEYS[lane];
+    accumulators[lane] = value * HASH_PRIME_32;
+  }
+}
+
+} // namespace detail
+
+// 64-bit hash of a byte range; 32-byte stripes are mixed with SIMD multiplies when available,
+// all code paths give the same value
+inline uint64_t hashBytes(const void* bytes, const size_t size, const uint64_t seed = 0)
+{
+  const unsigned char* data = static_cast<const unsigned char*>(bytes);
+  uint64_t accumulators[4] =
+  {
+    seed ^ detail::HASH_PRIME_1, seed + detail::HASH_PRIME_2, seed, seed - detail::HASH_PRIME_1
+  };
+
+  size_t offset = 0;
+  size_t stripes = 0;
+  for(; offset + detail::HASH_STRIPE <= size; offset += detail::HASH_STRIPE)
+  {
+    detail::hashStripe(accumulators, data + offset);
+    if(++stripes % detail::HASH_STRIPES_PER_BLOCK == 0)
+      detail::hashScramble(accumulators);
+  }
+
+  if(offset < size)
+  {
+    unsigned char tail[detail::HASH_STRIPE] = {};
+    std::memcpy(tail, data + offset, size - offset);
+    detail::hashStripe(accumulators, tail);
+  }
+
+  uint64_t result = size * detail::HASH_PRIME_1;
+  for(size_t lane = 0; lane < 4; ++lane)
+    result = detail::hashMix(result ^ detail::hashMix(accumulators[lane] + lane));
+  return result;
+}
+
+namespace detail
+{
+
+template<typename T>
+uint64_t hashElements(const Array<T>& array, std::true_type)
+{
+  return hashBytes(array.data(), array.size() * sizeof(T));
+}
+
+// floating point values are hashed by value so that 0.0 and -0.0 agree
+inline size_t hashValue(const float value)
+{
+  return value == 0 ? 0 : std::hash<float>()(value);
+}
+
+inline size_t hashValue(const double value)
+{
+  return value == 0 ? 0 : std::hash<double>()(value);
+}
+
+template<typename T>
+size_t hashValue(const T& value)
+{
+  return std::hash<T>()(value);
+}
+
+template<typename T>
+uint64_t hashElements(const Array<T>& array, std::false_type)
+{
+  uint64_t result = array.size() * HASH_PRIME_1;
+  for(size_t i = 0; i < array.size(); ++i)
+    result = hashMix(result ^ (hashValue(array[i]) + HASH_PRIME_2));
+  return result;
+}
+
+} // namespace detail
+
+// content hash: byte hash for bitwise comparable elements, std::hash of every element otherwise
+template<typename T>
+uint64_t hashArray(const Array<T>& array)
+{
+  return detail::hashElements(array, IsBitwiseComparable<T>());
+}
+
+namespace detail
+{
+
+template<typename T>
+bool equalElements(const Array<T>& first, const Array<T>& second, std::true_type)
+{
+  return !first.size() || !std::memcmp(first.data(), second.data(), first.size() * sizeof(T));
+}
+
+template<typename T>
+bool equalElements(const Array<T>& first, const Array<T>& second, std::false_type)
+{
+  return std::equal(first.begin(), first.end(), second.begin());
+}
+
+} // namespace detail
+
+template<typename T>
+bool operator ==(const Array<T>& first, const Array<T>& second)
+{
+  return first.size() == second.size()
+         && (first.data() == second.data() || detail::equalElements(first, second, IsBitwiseComparable<T>()));
+}
+
+template<typename T>
+bool operator !=(const Array<T>& first, const Array<T>& second)
+{
+  return !(first == second);
+}
+
+// an Array that is never modified again, so its hash is computed once; comparisons check the
+// hashes before touching the elements
+template<typename T>
+class HashedArray
+{
+public:
+  explicit HashedArray(Array<T> array = Array<T>())
+    : m_array(std::move(array))
+    , m_hash(hashArray(m_array))
+  {
+  }
+
+  const Array<T>& array() const
+  {
+    return m_array;
+  }
+
+  uint64_t hash() const
+  {
+    return m_hash;
+  }
+
+  const size_t size() const
+  {
+    return m_array.size();
+  }
+
+  const T& operator [](const size_t index) const
+  {
+    return m_array[index];
+  }
+
+  bool operator ==(const HashedArray& other) const
+  {
+    return m_hash == other.m_hash && m_array == other.m_array;
+  }
+
+  bool operator !=(const HashedArray& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  Array<T> m_array;
+  uint64_t m_hash;
+};
+
+namespace std
+{
+
+template<typename T>
+struct hash<Array<T> >
+{
+  size_t operator ()(const Array<T>& array) const
+  {
+    return static_cast<size_t>(hashArray(array));
+  }
+};
+
+template<typename T>
+struct hash<HashedArray<T> >
+{
+  size_t operator ()(const HashedArray<T>& array) const
+  {
+    return static_cast<size_t>(array.hash());
+  }
+};
+
+} // namespace std
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "array.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <type_traits>
+
+const size_t PARALLEL_HISTOGRAM_GRAIN = 1 << 16;
+
+// histograms up to this many bins get several interleaved sub-histograms per thread, so a run of
+// equal values increments different counters instead of waiting on its own previous store
+const size_t HISTOGRAM_LANE_BINS = 1 << 12;
+const size_t HISTOGRAM_LANES = 4;
+
+namespace detail
+{
+
+// counts binOf(value) for every value; binOf returns 'bins' for values that are dropped, which
+// lands them in a spare slot instead of needing a branch. Every thread owns private sub-histograms
+// (padded to whole cache lines) that are summed once at the end
+template<typename T, typename BinOf>
+Array<size_t> privatizedHistogram(const Array<T>& values, const size_t bins, BinOf binOf, const size_t countThreads)
+{
+  const size_t size = values.size();
+  const size_t threads = parallelThreadCount(size, PARALLEL_HISTOGRAM_GRAIN, countThreads);
+  const size_t lanes = bins <= HISTOGRAM_LANE_BINS ? HISTOGRAM_LANES : 1;
+  const size_t CACHE_LINE_COUNTERS = 64 / sizeof(size_t);
+  const size_t stride = (bins + 1 + CACHE_LINE_COUNTERS - 1) / CACHE_LINE_COUNTERS * CACHE_LINE_COUNTERS;
+
+  Array<size_t> local(threads * lanes * stride);
+  const T* data = values.data();
+
+  parallelFor(size, threads, [&](const size_t thread, const size_t begin, const size_t end)
+  {
+    size_t* counts = local.data() + thread * lanes * stride;
+    size_t i = begin;
+
+    if(lanes == HISTOGRAM_LANES)
+    {
+      size_t* lane1 = counts + stride;
+      size_t* lane2 = counts + 2 * stride;
+      size_t* lane3 = counts + 3 * stride;
+
+      for(; i + HISTOGRAM_LANES <= end; i += HISTOGRAM_LANES)
+      {
+        ++counts[binOf(data[i])];
+        ++lane1[binOf(data[i + 1])];
+        ++lane2[binOf(data[i + 2])];
+        ++lane3[binOf(data[i + 3])];
+      }
+    }
+
+    for(; i < end; ++i)
+      ++counts[binOf(data[i])];
+  });
+
+  Array<size_t> result(bins);
+  size_t* totals = result.data();
+  const size_t copies = threads * lanes;
+
+  parallelFor(bins, parallelThreadCount(bins * copies, PARALLEL_HISTOGRAM_GRAIN, countThreads),
+              [&](const size_t, const size_t begin, const size_t end)
+  {
+    for(size_t copy = 0; copy < copies; ++copy)
+    {
+      const size_t* counts = local.data() + copy * stride;
+      for(size_t bin = begin; bin < end; ++bin)
+        totals[bin] += counts[bin];
+    }
+  });
+
+  return result;
+}
+
+} // namespace detail
+
+// counts of every integer in [minValue, maxValue]: result[v - minValue]; values outside are ignored.
+// 'threads' overrides the thread count picked from the size and hardwareThreads()
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value, Array<size_t> >::type
+countValues(const Array<T>& values, const T minValue, const T maxValue, const size_t threads = 0)
+{
+  assert(minValue <= maxValue);
+
+  const long long low = minValue;
+  const size_t bins = static_cast<size_t>(static_cast<long long>(maxValue) - low) + 1;
+
+  return detail::privatizedHistogram(values, bins, [low, bins](const T value)
+  {
+    const size_t bin = static_cast<size_t>(static_cast<long long>(value) - low);
+    return bin < bins ? bin : bins;
+  }, threads);
+}
+
+// 'bins' equal-width bins over [low, high); values outside are ignored
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, Array<size_t> >::type
+histogram(const Array<T>& values, const T low, const T high, const size_t bins, const size_t threads = 0)
+{
+  assert(low < high && bins > 0);
+
+  const double origin = static_cast<double>(low);
+  const double scale = bins / (static_cast<double>(high) - origin);
+
+  return detail::privatizedHistogram(values, bins, [low, high, origin, scale, bins](const T value)
+  {
+    if(!(value >= low && value < high))
+      return bins;
+    return std::min(static_cast<size_t>((static_cast<double>(value) - origin) * scale), bins - 1);
+  }, threads);
+}
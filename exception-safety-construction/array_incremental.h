@@ -0,0 +1,126 @@
+#pragma once
+
+#include "array.h"
+
+#include <algorithm>
+#include <chrono>
+
+// elements copied per step by default, a few hundred microseconds of work for small elements
+const size_t INCREMENTAL_COPY_SLICE = 1 << 16;
+
+// copy of 'source' into 'target' that runs in bounded slices, for threads such as event loops
+// that cannot block for a whole copy: every step() copies one slice into a private staging
+// Array and returns, and only the last step swaps the staging Array into 'target'. Until then
+// 'target' is untouched, so abandoning the copy at any point, by cancel(), by destroying the
+// task or by an exception from an element copy, leaves it exactly as it was (strong guarantee).
+// 'source' must stay alive and unchanged while the copy runs. The staging Array is created by
+// the first step; for non-trivial elements that default-constructs all of them at once.
+// The old contents of 'target' are released with the task
+template<typename T>
+class IncrementalCopy
+{
+public:
+  IncrementalCopy(Array<T>& target, const Array<T>& source, const size_t slice = INCREMENTAL_COPY_SLICE)
+    : m_target(target)
+    , m_source(source)
+    , m_slice(slice ? slice : 1)
+    , m_copied(0)
+    , m_state(Pending)
+  {
+  }
+
+  IncrementalCopy(const IncrementalCopy&) = delete;
+  IncrementalCopy& operator=(const IncrementalCopy&) = delete;
+
+  // copies the next slice; true once the copy has been committed to the target. A copy that
+  // was cancelled or failed stays that way and returns false
+  bool step()
+  {
+    if(m_state == Committed || m_state == Cancelled)
+      return m_state == Committed;
+
+    try
+    {
+      if(m_state == Pending)
+      {
+        m_staging = Array<T>(m_source.size(), Uninitialized());
+        m_state = Copying;
+      }
+
+      const size_t end = std::min(m_copied + m_slice, m_source.size());
+      std::copy(m_source.data() + m_copied, m_source.data() + end, m_staging.data() + m_copied);
+      m_copied = end;
+    }
+    catch(...)
+    {
+      cancel();
+      throw;
+    }
+
+    // the old contents of the target stay in m_staging until the task is destroyed, freeing
+    // them here would make the commit step the longest one
+    if(m_copied == m_source.size())
+    {
+      m_target.swap(m_target, m_staging);
+      m_state = Committed;
+    }
+
+    return m_state == Committed;
+  }
+
+  // steps until the copy is committed or 'budget' has run out; at least one step runs
+  template<typename Rep, typename Period>
+  bool runFor(const std::chrono::duration<Rep, Period> budget)
+  {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + budget;
+
+    while(!step())
+      if(m_state == Cancelled || Clock::now() >= deadline)
+        return false;
+
+    return true;
+  }
+
+  // drops the partial copy; the target keeps its old contents
+  void cancel()
+  {
+    if(m_state == Committed)
+      return;
+
+    m_staging = Array<T>();
+    m_state = Cancelled;
+  }
+
+  bool committed() const
+  {
+    return m_state == Committed;
+  }
+
+  bool cancelled() const
+  {
+    return m_state == Cancelled;
+  }
+
+  // elements copied so far
+  size_t copied() const
+  {
+    return m_copied;
+  }
+
+private:
+  enum State
+  {
+    Pending,
+    Copying,
+    Committed,
+    Cancelled
+  };
+
+  Array<T>& m_target;
+  const Array<T>& m_source;
+  const size_t m_slice;
+  Array<T> m_staging;
+  size_t m_copied;
+  State m_state;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// bit, prefetch and mixing helpers shared by the kernels, kept apart so a header that needs
+// one of them does not pull in the container it first lived in
+namespace detail
+{
+
+const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ull;
+const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+// index of the lowest set bit; 'mask' must not be 0
+inline unsigned lowestBit(const unsigned mask)
+{
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+  unsigned bit = 0;
+  while(!(mask & (1u << bit)))
+    ++bit;
+  return bit;
+#endif
+}
+
+inline void prefetchRead(const void* address)
+{
+#if defined(__GNUC__)
+  __builtin_prefetch(address, 0);
+#else
+  (void)address;
+#endif
+}
+
+inline void prefetchWrite(const void* address)
+{
+#if defined(__GNUC__)
+  __builtin_prefetch(address, 1);
+#else
+  (void)address;
+#endif
+}
+
+// final avalanche of a 64-bit hash: every input bit affects every output bit
+inline uint64_t hashMix(uint64_t value)
+{
+  value ^= value >> 33;
+  value *= HASH_PRIME_2;
+  value ^= value >> 29;
+  value *= HASH_PRIME_1;
+  value ^= value >> 32;
+  return value;
+}
+
+} // namespace detail
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "array_policies.h"
+
+#include <assert.h>
+#include <cstddef> // size_t, ptrdiff_t
+#include <iterator>
+#include <type_traits>
+
+// build with -DARRAY_CHECKED_ITERATORS=1 to give the Arrays of AssertBoundsCheck checked
+// iterators as well; like the assert itself it is off under NDEBUG, so release builds keep
+// plain pointers
+#ifndef ARRAY_CHECKED_ITERATORS
+#define ARRAY_CHECKED_ITERATORS 0
+#endif
+
+// random access iterator that knows the range it walks and passes every access through the
+// BoundsCheck policy of its Array, so *end(), begin()[size] or an iterator moved past either
+// end is caught where it is used instead of where the memory it clobbered is read. Stepping
+// outside the range is allowed, as with pointers; only the accesses are checked
+template<typename T, typename BoundsCheck>
+class CheckedIterator
+{
+public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef typename std::remove_const<T>::type value_type;
+  typedef ptrdiff_t difference_type;
+  typedef T* pointer;
+  typedef T& reference;
+
+  CheckedIterator()
+    : m_position(nullptr)
+    , m_begin(nullptr)
+    , m_end(nullptr)
+  {
+  }
+
+  CheckedIterator(T* position, T* begin, T* end)
+    : m_position(position)
+    , m_begin(begin)
+    , m_end(end)
+  {
+  }
+
+  // iterator -> const_iterator
+  template<typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+  CheckedIterator(const CheckedIterator<U, BoundsCheck>& other)
+    : m_position(other.m_position)
+    , m_begin(other.m_begin)
+    , m_end(other.m_end)
+  {
+  }
+
+  // the pointer, unchecked
+  T* base() const
+  {
+    return m_position;
+  }
+
+  T& operator *() const
+  {
+    return at(m_position);
+  }
+
+  T* operator ->() const
+  {
+    return &at(m_position);
+  }
+
+  T& operator [](const difference_type offset) const
+  {
+    return at(m_position + offset);
+  }
+
+  CheckedIterator& operator ++()
+  {
+    ++m_position;
+    return *this;
+  }
+
+  CheckedIterator operator ++(int)
+  {
+    CheckedIterator previous = *this;
+    ++m_position;
+    return previous;
+  }
+
+  CheckedIterator& operator --()
+  {
+    --m_position;
+    return *this;
+  }
+
+  CheckedIterator operator --(int)
+  {
+    CheckedIterator previous = *this;
+    --m_position;
+    return previous;
+  }
+
+  CheckedIterator& operator +=(const difference_type offset)
+  {
+    m_position += offset;
+    return *this;
+  }
+
+  CheckedIterator& operator -=(const difference_type offset)
+  {
+    m_position -= offset;
+    return *this;
+  }
+
+  CheckedIterator operator +(const difference_type offset) const
+  {
+    return CheckedIterator(m_position + offset, m_begin, m_end);
+  }
+
+  CheckedIterator operator -(const difference_type offset) const
+  {
+    return CheckedIterator(m_position - offset, m_begin, m_end);
+  }
+
+  friend CheckedIterator operator +(const difference_type offset, const CheckedIterator& iterator)
+  {
+    return iterator + offset;
+  }
+
+  // iterators of different Arrays are not comparable; that is only asserted, the policy
+  // checks indices
+  template<typename U>
+  difference_type operator -(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    assert(m_begin == other.m_begin);
+    return m_position - other.m_position;
+  }
+
+  template<typename U>
+  bool operator ==(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    assert(m_begin == other.m_begin);
+    return m_position == other.m_position;
+  }
+
+  template<typename U>
+  bool operator !=(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    return !(*this == other);
+  }
+
+  template<typename U>
+  bool operator <(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    return *this - other < 0;
+  }
+
+  template<typename U>
+  bool operator >(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    return *this - other > 0;
+  }
+
+  template<typename U>
+  bool operator <=(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    return *this - other <= 0;
+  }
+
+  template<typename U>
+  bool operator >=(const CheckedIterator<U, BoundsCheck>& other) const
+  {
+    return *this - other >= 0;
+  }
+
+private:
+  template<typename, typename>
+  friend class CheckedIterator;
+
+  // a position before the range wraps around to a huge index and fails the check as well
+  T& at(T* position) const
+  {
+    BoundsCheck::check(static_cast<size_t>(position - m_begin), static_cast<size_t>(m_end - m_begin));
+
+    return *position;
+  }
+
+  T* m_position;
+  T* m_begin;
+  T* m_end;
+};
+
+namespace detail
+{
+
+// policies whose Arrays hand out CheckedIterators: the ones that check in release builds, and
+// AssertBoundsCheck when asked to
+template<typename BoundsCheck>
+struct ChecksIterators : std::false_type
+{
+};
+
+template<>
+struct ChecksIterators<ThrowBoundsCheck> : std::true_type
+{
+};
+
+template<size_t Period>
+struct ChecksIterators<SampledBoundsCheck<Period> > : std::true_type
+{
+};
+
+#if ARRAY_CHECKED_ITERATORS && !defined(NDEBUG)
+template<>
+struct ChecksIterators<AssertBoundsCheck> : std::true_type
+{
+};
+#endif
+
+// iterator type of Array<T, BoundsCheck> and how to make one from a pointer into its range
+template<typename T, typename BoundsCheck, bool Checked = ChecksIterators<BoundsCheck>::value>
+struct ArrayIterator
+{
+  typedef T* type;
+
+  static type make(T* position, T*, T*)
+  {
+    return position;
+  }
+};
+
+template<typename T, typename BoundsCheck>
+struct ArrayIterator<T, BoundsCheck, true>
+{
+  typedef CheckedIterator<T, BoundsCheck> type;
+
+  static type make(T* position, T* begin, T* end)
+  {
+    return type(position, begin, end);
+  }
+};
+
+} // namespace detail
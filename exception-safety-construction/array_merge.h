@@ -0,0 +1,322 @@
+#pragma once
+
+#include "array.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <functional> // std::less
+#include <iterator>
+
+// below this many elements per thread the merges run on one thread
+const size_t PARALLEL_SET_GRAIN = 1 << 15;
+
+namespace detail
+{
+
+// tournament tree over k sorted ranges: every inner node keeps the loser of the match played
+// there and node 0 the overall winner, so replacing the winner replays a single leaf-to-root path
+template<typename T, typename Compare>
+class LoserTree
+{
+public:
+  LoserTree(const size_t count, Compare less)
+    : m_count(count)
+    , m_less(less)
+    , m_current(count, Uninitialized())
+    , m_end(count, Uninitialized())
+    , m_tree(count ? count : 1)
+  {
+  }
+
+  void setSource(const size_t source, const T* begin, const T* end)
+  {
+    m_current[source] = begin;
+    m_end[source] = end;
+  }
+
+  void build()
+  {
+    m_tree[0] = m_count ? play(1) : 0;
+  }
+
+  bool empty() const
+  {
+    return !m_count || m_current[m_tree[0]] == m_end[m_tree[0]];
+  }
+
+  const T& top() const
+  {
+    return *m_current[m_tree[0]];
+  }
+
+  void pop()
+  {
+    size_t winner = m_tree[0];
+    ++m_current[winner];
+
+    for(size_t node = (winner + m_count) / 2; node > 0; node /= 2)
+      if(beats(m_tree[node], winner))
+        std::swap(m_tree[node], winner);
+
+    m_tree[0] = winner;
+  }
+
+private:
+  // exhausted sources lose to everything, ties go to the lower source index
+  bool beats(const size_t left, const size_t right) const
+  {
+    if(m_current[left] == m_end[left])
+      return false;
+    if(m_current[right] == m_end[right])
+      return true;
+    if(m_less(*m_current[right], *m_current[left]))
+      return false;
+    return left < right || m_less(*m_current[left], *m_current[right]);
+  }
+
+  // leaves are nodes [count, 2 * count), returns the winner of the subtree at 'node'
+  size_t play(const size_t node)
+  {
+    if(node >= m_count)
+      return node - m_count;
+
+    const size_t left = play(2 * node);
+    const size_t right = play(2 * node + 1);
+
+    if(beats(left, right))
+    {
+      m_tree[node] = right;
+      return left;
+    }
+
+    m_tree[node] = left;
+    return right;
+  }
+
+  size_t m_count;
+  Compare m_less;
+  Array<const T*> m_current;
+  Array<const T*> m_end;
+  Array<size_t> m_tree;
+};
+
+// output iterator that only counts what is written
+class CountingIterator
+{
+public:
+  typedef std::output_iterator_tag iterator_category;
+  typedef void value_type;
+  typedef void difference_type;
+  typedef void pointer;
+  typedef void reference;
+
+  explicit CountingIterator(size_t& count)
+    : m_count(&count)
+  {
+  }
+
+  CountingIterator& operator *()
+  {
+    return *this;
+  }
+
+  template<typename T>
+  CountingIterator& operator =(const T&)
+  {
+    ++*m_count;
+    return *this;
+  }
+
+  CountingIterator& operator ++()
+  {
+    return *this;
+  }
+
+  CountingIterator operator ++(int)
+  {
+    return *this;
+  }
+
+private:
+  size_t* m_count;
+};
+
+// runs a std::set_* style algorithm on 'threads' slices of two sorted arrays; slices are cut at
+// splitter values taken from the larger input, so equal elements always land in the same slice;
+// a counting pass sizes the result exactly before the write pass fills it
+template<typename T, typename Compare, typename Operation>
+Array<T> parallelSetOperation(const Array<T>& first, const Array<T>& second, Compare less, Operation operation,
+                              const size_t setThreads)
+{
+  const Array<T>& larger = first.size() >= second.size() ? first : second;
+  // every slice boundary takes its splitter from the larger input, so there are at most as many
+  // slices as it has elements
+  const size_t wanted = parallelThreadCount(first.size() + second.size(), PARALLEL_SET_GRAIN, setThreads);
+  const size_t threads = std::max<size_t>(1, std::min(wanted, larger.size()));
+
+  Array<size_t> firstBounds(threads + 1);
+  Array<size_t> secondBounds(threads + 1);
+  for(size_t t = 1; t < threads; ++t)
+  {
+    const T& splitter = larger[partitionBegin(larger.size(), threads, t)];
+    firstBounds[t] = std::lower_bound(first.begin(), first.end(), splitter, less) - first.begin();
+    secondBounds[t] = std::lower_bound(second.begin(), second.end(), splitter, less) - second.begin();
+  }
+  firstBounds[threads] = first.size();
+  secondBounds[threads] = second.size();
+
+  Array<size_t> offsets(threads + 1);
+  parallelFor(threads, threads, [&](const size_t t, const size_t, const size_t)
+  {
+    operation(first.begin() + firstBounds[t], first.begin() + firstBounds[t + 1],
+              second.begin() + secondBounds[t], second.begin() + secondBounds[t + 1],
+              CountingIterator(offsets[t + 1]), less);
+  });
+
+  for(size_t t = 0; t < threads; ++t)
+    offsets[t + 1] += offsets[t];
+
+  Array<T> result(offsets[threads], Uninitialized());
+  parallelFor(threads, threads, [&](const size_t t, const size_t, const size_t)
+  {
+    operation(first.begin() + firstBounds[t], first.begin() + firstBounds[t + 1],
+              second.begin() + secondBounds[t], second.begin() + secondBounds[t + 1],
+              result.begin() + offsets[t], less);
+  });
+
+  return result;
+}
+
+struct SetUnion
+{
+  template<typename In, typename Out, typename Compare>
+  Out operator ()(In first, In firstEnd, In second, In secondEnd, Out out, Compare less) const
+  {
+    return std::set_union(first, firstEnd, second, secondEnd, out, less);
+  }
+};
+
+struct SetIntersection
+{
+  template<typename In, typename Out, typename Compare>
+  Out operator ()(In first, In firstEnd, In second, In secondEnd, Out out, Compare less) const
+  {
+    return std::set_intersection(first, firstEnd, second, secondEnd, out, less);
+  }
+};
+
+struct SetDifference
+{
+  template<typename In, typename Out, typename Compare>
+  Out operator ()(In first, In firstEnd, In second, In secondEnd, Out out, Compare less) const
+  {
+    return std::set_difference(first, firstEnd, second, secondEnd, out, less);
+  }
+};
+
+} // namespace detail
+
+// stable merge of 'count' sorted shards into one presized array; the output is cut into slices
+// at sampled splitter values, each slice locates its piece of every shard by binary search and
+// drains it through its own loser tree. 'threads' (after the comparator, as for the set
+// operations) overrides the thread count picked from the size and hardwareThreads()
+template<typename T, typename Compare>
+Array<T> kWayMerge(const Array<T>* shards, const size_t count, Compare less, const size_t mergeThreads = 0)
+{
+  size_t total = 0;
+  for(size_t s = 0; s < count; ++s)
+    total += shards[s].size();
+
+  Array<T> result(total, Uninitialized());
+  if(!total)
+    return result;
+
+  // splitters are picked from a sorted sample of every shard
+  const size_t threads = parallelThreadCount(total, PARALLEL_SET_GRAIN, mergeThreads);
+  Array<T> samples(threads * count, Uninitialized());
+  size_t sampleCount = 0;
+  for(size_t s = 0; s < count; ++s)
+    for(size_t t = 0; t < threads && shards[s].size(); ++t)
+      samples[sampleCount++] = shards[s][partitionBegin(shards[s].size(), threads, t)];
+  std::sort(samples.begin(), samples.begin() + sampleCount, less);
+
+  // bounds[t * count + s] is where slice t starts in shard s
+  Array<size_t> bounds((threads + 1) * count);
+  for(size_t s = 0; s < count; ++s)
+  {
+    for(size_t t = 1; t < threads; ++t)
+    {
+      const T& splitter = samples[partitionBegin(sampleCount, threads, t)];
+      bounds[t * count + s] = std::lower_bound(shards[s].begin(), shards[s].end(), splitter, less) - shards[s].begin();
+    }
+    bounds[threads * count + s] = shards[s].size();
+  }
+
+  parallelFor(threads, threads, [&](const size_t t, const size_t, const size_t)
+  {
+    size_t offset = 0;
+    for(size_t s = 0; s < count; ++s)
+      offset += bounds[t * count + s];
+
+    detail::LoserTree<T, Compare> tree(count, less);
+    for(size_t s = 0; s < count; ++s)
+      tree.setSource(s, shards[s].data() + bounds[t * count + s], shards[s].data() + bounds[(t + 1) * count + s]);
+    tree.build();
+
+    T* out = result.data() + offset;
+    for(; !tree.empty(); tree.pop())
+      *out++ = tree.top();
+  });
+
+  return result;
+}
+
+template<typename T>
+Array<T> kWayMerge(const Array<T>* shards, const size_t count)
+{
+  return kWayMerge(shards, count, std::less<T>());
+}
+
+template<typename T>
+Array<T> kWayMerge(const Array<Array<T> >& shards)
+{
+  return kWayMerge(shards.data(), shards.size(), std::less<T>());
+}
+
+// multiset union, intersection and difference with std::set_* semantics; 'threads' overrides
+// the thread count picked from the sizes and hardwareThreads()
+template<typename T, typename Compare>
+Array<T> setUnion(const Array<T>& first, const Array<T>& second, Compare less, const size_t threads = 0)
+{
+  return detail::parallelSetOperation(first, second, less, detail::SetUnion(), threads);
+}
+
+template<typename T>
+Array<T> setUnion(const Array<T>& first, const Array<T>& second)
+{
+  return setUnion(first, second, std::less<T>());
+}
+
+template<typename T, typename Compare>
+Array<T> setIntersection(const Array<T>& first, const Array<T>& second, Compare less, const size_t threads = 0)
+{
+  return detail::parallelSetOperation(first, second, less, detail::SetIntersection(), threads);
+}
+
+template<typename T>
+Array<T> setIntersection(const Array<T>& first, const Array<T>& second)
+{
+  return setIntersection(first, second, std::less<T>());
+}
+
+template<typename T, typename Compare>
+Array<T> setDifference(const Array<T>& first, const Array<T>& second, Compare less, const size_t threads = 0)
+{
+  return detail::parallelSetOperation(first, second, less, detail::SetDifference(), threads);
+}
+
+template<typename T>
+Array<T> setDifference(const Array<T>& first, const Array<T>& second)
+{
+  return setDifference(first, second, std::less<T>());
+}
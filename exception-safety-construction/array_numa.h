@@ -0,0 +1,198 @@
+#pragma once
+
+#include "array.h"
+#include "parallel.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// below this many elements per thread a parallel first touch is not worth the threads
+const size_t NUMA_TOUCH_GRAIN = 1 << 16;
+// nodes an interleave mask can name, one bit of an unsigned long each
+const size_t NUMA_MASK_BITS = 8 * sizeof(unsigned long);
+
+enum class NumaPlacement
+{
+  // every page lands on the node of the thread that later processes it
+  FirstTouch,
+  // pages are spread round-robin over all nodes, for data every thread reads everywhere
+  Interleave
+};
+
+namespace detail
+{
+
+// counts the nodes in a sysfs list such as "0", "0-1" or "0,2-3"
+inline size_t countNodes(const std::string& list)
+{
+  size_t nodes = 0;
+  size_t position = 0;
+
+  while(position < list.size())
+  {
+    size_t end = list.find(',', position);
+    if(end == std::string::npos)
+      end = list.size();
+
+    const std::string range = list.substr(position, end - position);
+    const size_t dash = range.find('-');
+    if(dash == std::string::npos)
+      nodes += !range.empty();
+    else
+      nodes += std::stoul(range.substr(dash + 1)) - std::stoul(range.substr(0, dash)) + 1;
+
+    position = end + 1;
+  }
+
+  return nodes;
+}
+
+// bit n set for every node n in a sysfs list such as "0,2-3"; 0 when a node does not fit the
+// NUMA_MASK_BITS of the mask
+inline unsigned long nodeMask(const std::string& list)
+{
+  unsigned long mask = 0;
+  size_t position = 0;
+
+  while(position < list.size())
+  {
+    size_t end = list.find(',', position);
+    if(end == std::string::npos)
+      end = list.size();
+
+    const std::string range = list.substr(position, end - position);
+    if(!range.empty())
+    {
+      const size_t dash = range.find('-');
+      const unsigned long first = std::stoul(range.substr(0, dash));
+      const unsigned long last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      if(last >= NUMA_MASK_BITS)
+        return 0;
+
+      for(unsigned long node = first; node <= last; ++node)
+        mask |= 1ul << node;
+    }
+
+    position = end + 1;
+  }
+
+  return mask;
+}
+
+// asks the kernel to interleave the whole pages of [memory, memory + bytes) over the nodes
+// set in 'nodes'; false when the system has no mbind or refuses, the placement is then the
+// default one
+inline bool interleavePages(void* memory, const size_t bytes, const unsigned long nodes)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  // MPOL_INTERLEAVE from <linux/mempolicy.h>, spelled out to avoid depending on kernel headers
+  const int POLICY_INTERLEAVE = 3;
+
+  // fewer than two nodes
+  if(!(nodes & (nodes - 1)))
+    return false;
+
+  const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t begin = (reinterpret_cast<uintptr_t>(memory) + page - 1) & ~(page - 1);
+  const uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + bytes) & ~(page - 1);
+  if(begin >= end)
+    return false;
+
+  return !syscall(SYS_mbind, begin, end - begin, POLICY_INTERLEAVE, &nodes, NUMA_MASK_BITS + 1, 0);
+#else
+  (void)memory;
+  (void)bytes;
+  (void)nodes;
+  return false;
+#endif
+}
+
+template<typename T>
+void touchInParallel(Array<T>& array, const size_t threads)
+{
+  T* data = array.data();
+  parallelFor(array.size(), threads, [data](const size_t, const size_t begin, const size_t end)
+  {
+    for(size_t i = begin; i < end; ++i)
+      data[i] = T();
+  });
+}
+
+inline std::string onlineNodes()
+{
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string list;
+  online >> list;
+  return list;
+}
+
+} // namespace detail
+
+// memory nodes online, 1 when the system does not tell
+inline size_t numaNodeCount()
+{
+  static const size_t nodes = []() -> size_t
+  {
+    try
+    {
+      const size_t count = detail::countNodes(detail::onlineNodes());
+      return count ? count : size_t(1);
+    }
+    catch(const std::exception&)
+    {
+      return size_t(1);
+    }
+  }();
+
+  return nodes;
+}
+
+// bit n set for every memory node n online; node numbers need not be contiguous, as after a
+// node is taken offline. 0 when the system does not tell or has nodes beyond NUMA_MASK_BITS
+inline unsigned long numaNodeMask()
+{
+  static const unsigned long mask = []() -> unsigned long
+  {
+    try
+    {
+      return detail::nodeMask(detail::onlineNodes());
+    }
+    catch(const std::exception&)
+    {
+      return 0ul;
+    }
+  }();
+
+  return mask;
+}
+
+// value-initialized Array whose pages are first touched by the chunks of
+// parallelFor(size, threads, ...), so a kernel that later runs with the same thread count
+// finds its chunk on its own node; with Interleave the pages are spread over all nodes
+// instead. Needs trivial elements, which leave the allocation untouched, and an allocation
+// big enough for the allocator to take fresh pages from the kernel. Other elements, a
+// single node or a system without mbind get an ordinary Array with the same contents.
+// The threads are not pinned: the placement holds as long as the scheduler keeps worker t
+// on the same node from one parallelFor to the next
+template<typename T>
+Array<T> numaArray(const size_t size, const NumaPlacement placement = NumaPlacement::FirstTouch,
+                   const size_t threads = 0)
+{
+  if(!std::is_trivial<T>::value)
+    return Array<T>(size);
+
+  Array<T> array(size, Uninitialized());
+
+  if(placement == NumaPlacement::Interleave)
+    detail::interleavePages(array.data(), size * sizeof(T), numaNodeMask());
+
+  detail::touchInParallel(array, threads ? threads : parallelThreadCount(size, NUMA_TOUCH_GRAIN));
+  return array;
+}
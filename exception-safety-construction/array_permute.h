@@ -0,0 +1,188 @@
+#pragma once
+
+#include "array.h"
+#include "array_intrinsics.h" // detail::prefetchRead, detail::prefetchWrite
+#include "parallel.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility> // std::move
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// how many elements ahead the random side of gather/scatter is prefetched
+const size_t PERMUTE_PREFETCH_DISTANCE = 16;
+const size_t PARALLEL_PERMUTE_GRAIN = 1 << 16;
+
+namespace detail
+{
+
+template<typename T, typename I>
+void gatherRange(const T* source, const size_t sourceSize, const I* indices, T* out, const size_t begin, const size_t end)
+{
+  (void)sourceSize;
+
+  size_t i = begin;
+  for(; i + PERMUTE_PREFETCH_DISTANCE < end; ++i)
+  {
+    prefetchRead(source + indices[i + PERMUTE_PREFETCH_DISTANCE]);
+    assert(static_cast<size_t>(indices[i]) < sourceSize);
+    out[i] = source[indices[i]];
+  }
+
+  for(; i < end; ++i)
+  {
+    assert(static_cast<size_t>(indices[i]) < sourceSize);
+    out[i] = source[indices[i]];
+  }
+}
+
+#if defined(__AVX2__)
+// hardware gather pays off for 32-bit elements with 32-bit indices: eight loads per instruction
+template<typename T, typename I>
+typename std::enable_if<sizeof(T) == 4 && sizeof(I) == 4 && std::is_trivially_copyable<T>::value>::type
+avx2GatherRange(const T* source, const I* indices, T* out, const size_t begin, const size_t end)
+{
+  const int* base = reinterpret_cast<const int*>(source);
+  size_t i = begin;
+
+  for(; i + 8 + PERMUTE_PREFETCH_DISTANCE <= end; i += 8)
+  {
+    prefetchRead(source + indices[i + PERMUTE_PREFETCH_DISTANCE]);
+    prefetchRead(source + indices[i + PERMUTE_PREFETCH_DISTANCE + 4]);
+    const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_i32gather_epi32(base, offsets, 4));
+  }
+
+  for(; i < end; ++i)
+    out[i] = source[indices[i]];
+}
+#endif
+
+template<typename T, typename I>
+void gatherDispatch(const T* source, const size_t sourceSize, const I* indices, T* out, const size_t begin, const size_t end,
+                    std::false_type)
+{
+  gatherRange(source, sourceSize, indices, out, begin, end);
+}
+
+template<typename T, typename I>
+void gatherDispatch(const T* source, const size_t sourceSize, const I* indices, T* out, const size_t begin, const size_t end,
+                    std::true_type)
+{
+#if defined(__AVX2__) && defined(NDEBUG)
+  // the hardware gather takes signed offsets
+  if(sourceSize <= 0x7fffffff)
+  {
+    avx2GatherRange(source, indices, out, begin, end);
+    return;
+  }
+#endif
+  gatherRange(source, sourceSize, indices, out, begin, end);
+}
+
+} // namespace detail
+
+// result[i] = source[indices[i]]; chunks run in parallel and every chunk prefetches the
+// source element it will need PERMUTE_PREFETCH_DISTANCE steps later
+template<typename T, typename I>
+Array<T> gather(const Array<T>& source, const Array<I>& indices)
+{
+  typedef std::integral_constant<bool, sizeof(T) == 4 && sizeof(I) == 4 && std::is_integral<I>::value
+                                       && std::is_trivially_copyable<T>::value> UseHardwareGather;
+
+  Array<T> result(indices.size(), Uninitialized());
+
+  parallelFor(indices.size(), parallelThreadCount(indices.size(), PARALLEL_PERMUTE_GRAIN),
+              [&](const size_t, const size_t begin, const size_t end)
+  {
+    detail::gatherDispatch(source.data(), source.size(), indices.data(), result.data(), begin, end, UseHardwareGather());
+  });
+
+  return result;
+}
+
+// destination[indices[i]] = source[i]; indices must be distinct, chunks run in parallel
+template<typename T, typename I>
+void scatter(const Array<T>& source, const Array<I>& indices, Array<T>& destination)
+{
+  assert(source.size() == indices.size());
+
+  const T* from = source.data();
+  const I* to = indices.data();
+  T* out = destination.data();
+  const size_t size = destination.size();
+  (void)size;
+
+  parallelFor(indices.size(), parallelThreadCount(indices.size(), PARALLEL_PERMUTE_GRAIN),
+              [&](const size_t, const size_t begin, const size_t end)
+  {
+    size_t i = begin;
+    for(; i + PERMUTE_PREFETCH_DISTANCE < end; ++i)
+    {
+      detail::prefetchWrite(out + to[i + PERMUTE_PREFETCH_DISTANCE]);
+      assert(static_cast<size_t>(to[i]) < size);
+      out[to[i]] = from[i];
+    }
+
+    for(; i < end; ++i)
+    {
+      assert(static_cast<size_t>(to[i]) < size);
+      out[to[i]] = from[i];
+    }
+  });
+}
+
+// reorders 'array' so that element i becomes the old element permutation[i], through a gathered copy
+template<typename T, typename I>
+void applyPermutation(Array<T>& array, const Array<I>& permutation)
+{
+  assert(array.size() == permutation.size());
+
+  Array<T> result = gather(array, permutation);
+  array.swap(array, result);
+}
+
+// same as applyPermutation but follows the cycles of 'permutation' in place, so the only extra
+// memory is one bit per element instead of a second array; every step of a cycle depends on the
+// previous load, so it is much slower than applyPermutation on large random permutations;
+// runs on one thread and leaves the order unspecified if a move assignment throws
+template<typename T, typename I>
+void applyPermutationInPlace(Array<T>& array, const Array<I>& permutation)
+{
+  assert(array.size() == permutation.size());
+
+  const size_t size = array.size();
+  const size_t BITS = 64;
+  Array<uint64_t> visited((size + BITS - 1) / BITS);
+  T* data = array.data();
+  const I* next = permutation.data();
+
+  for(size_t start = 0; start < size; ++start)
+  {
+    if(visited[start / BITS] & (uint64_t(1) << (start % BITS)))
+      continue;
+
+    T carried = std::move(data[start]);
+    size_t current = start;
+
+    for(;;)
+    {
+      visited[current / BITS] |= uint64_t(1) << (current % BITS);
+      const size_t source = static_cast<size_t>(next[current]);
+      assert(source < size);
+
+      if(source == start)
+      {
+        data[current] = std::move(carried);
+        break;
+      }
+
+      detail::prefetchRead(data + next[source]);
+      data[current] = std::move(data[source]);
+      current = source;
+    }
+  }
+}
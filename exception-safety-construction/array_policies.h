@@ -0,0 +1,284 @@
+#pragma once
+
+#include <assert.h>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define ARRAY_HAS_MMAP 1
+#endif
+
+// compile-time policies of Array. A bounds check policy provides
+//   static void check(size_t index, size_t size);
+// and a storage policy provides
+//   template<typename T> static void* allocate(size_t bytes);
+//   template<typename T> static void deallocate(void* memory, size_t bytes) noexcept;
+
+// release builds: operator[] compiles to the bare access
+struct NoBoundsCheck
+{
+  static void check(const size_t, const size_t)
+  {
+  }
+};
+
+// the original behaviour, checked unless NDEBUG
+struct AssertBoundsCheck
+{
+  static void check(const size_t index, const size_t size)
+  {
+    assert(index < size);
+    (void)index;
+    (void)size;
+  }
+};
+
+// always checked, independent of NDEBUG
+struct ThrowBoundsCheck
+{
+  static void check(const size_t index, const size_t size)
+  {
+    if(index >= size)
+      throwOutOfRange(index, size);
+  }
+
+  static void throwOutOfRange(const size_t index, const size_t size)
+  {
+    throw std::out_of_range("Array index " + std::to_string(index) + " out of range " + std::to_string(size));
+  }
+};
+
+// checks one access in every 'Period' (a power of two) per thread, for canary builds that want
+// to catch bad indices in production at a fraction of the cost of checking all of them
+template<size_t Period = 64>
+struct SampledBoundsCheck
+{
+  static_assert(Period && !(Period & (Period - 1)), "sampling period must be a power of two");
+
+  static void check(const size_t index, const size_t size)
+  {
+    if(!(++counter() & (Period - 1)) && index >= size)
+      ThrowBoundsCheck::throwOutOfRange(index, size);
+  }
+
+  static size_t& counter()
+  {
+    static thread_local size_t accesses = 0;
+    return accesses;
+  }
+};
+
+// build-wide default, e.g. -DARRAY_DEFAULT_BOUNDS_CHECK=ThrowBoundsCheck for a canary build
+#ifndef ARRAY_DEFAULT_BOUNDS_CHECK
+#define ARRAY_DEFAULT_BOUNDS_CHECK AssertBoundsCheck
+#endif
+
+namespace detail
+{
+
+// element types with their own operator new[] (like the Foo of the tests) keep using it
+template<typename T, typename = void>
+struct HasArrayNew : std::false_type
+{
+};
+
+template<typename T>
+struct HasArrayNew<T, decltype(void(T::operator new[](size_t(0))))> : std::true_type
+{
+};
+
+} // namespace detail
+
+// global heap, the original storage
+struct HeapStorage
+{
+  template<typename T>
+  static void* allocate(const size_t bytes)
+  {
+    return allocate<T>(bytes, detail::HasArrayNew<T>());
+  }
+
+  template<typename T>
+  static void deallocate(void* memory, const size_t) noexcept
+  {
+    deallocate<T>(memory, detail::HasArrayNew<T>());
+  }
+
+private:
+  // templates so that only the overload in use is instantiated
+  template<typename T>
+  static void* allocate(const size_t bytes, std::true_type)
+  {
+    return T::operator new[](bytes);
+  }
+
+  template<typename T>
+  static void* allocate(const size_t bytes, std::false_type)
+  {
+    return ::operator new[](bytes);
+  }
+
+  template<typename T>
+  static void deallocate(void* memory, std::true_type) noexcept
+  {
+    T::operator delete[](memory);
+  }
+
+  template<typename T>
+  static void deallocate(void* memory, std::false_type) noexcept
+  {
+    ::operator delete[](memory);
+  }
+};
+
+// bump allocator for batches of short-lived Arrays: allocation is a pointer increment and
+// freeing an Array is a no-op, the memory comes back when the arena is released or destroyed
+class Arena
+{
+public:
+  explicit Arena(const size_t blockSize = 1 << 20)
+    : m_blockSize(blockSize)
+    , m_blocks(nullptr)
+    , m_position(nullptr)
+    , m_end(nullptr)
+  {
+  }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena()
+  {
+    release();
+  }
+
+  void* allocate(const size_t bytes, const size_t alignment)
+  {
+    uintptr_t position = (reinterpret_cast<uintptr_t>(m_position) + alignment - 1) & ~uintptr_t(alignment - 1);
+    if(!m_position || position + bytes > reinterpret_cast<uintptr_t>(m_end))
+    {
+      addBlock(bytes + alignment);
+      position = (reinterpret_cast<uintptr_t>(m_position) + alignment - 1) & ~uintptr_t(alignment - 1);
+    }
+
+    m_position = reinterpret_cast<char*>(position + bytes);
+    return reinterpret_cast<void*>(position);
+  }
+
+  // frees every block; Arrays allocated from the arena must be gone by now
+  void release()
+  {
+    while(m_blocks)
+    {
+      Block* next = m_blocks->next;
+      ::operator delete(m_blocks);
+      m_blocks = next;
+    }
+
+    m_position = m_end = nullptr;
+  }
+
+  // the arena ArenaStorage allocates from on this thread
+  static Arena*& current()
+  {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+  }
+
+private:
+  struct Block
+  {
+    Block* next;
+  };
+
+  void addBlock(const size_t minimum)
+  {
+    const size_t bytes = sizeof(Block) + (minimum > m_blockSize ? minimum : m_blockSize);
+    Block* block = static_cast<Block*>(::operator new(bytes));
+    block->next = m_blocks;
+    m_blocks = block;
+    m_position = reinterpret_cast<char*>(block + 1);
+    m_end = reinterpret_cast<char*>(block) + bytes;
+  }
+
+  const size_t m_blockSize;
+  Block* m_blocks;
+  char* m_position;
+  char* m_end;
+};
+
+// makes an arena current for the calling thread while in scope
+class ArenaScope
+{
+public:
+  explicit ArenaScope(Arena& arena)
+    : m_previous(Arena::current())
+  {
+    Arena::current() = &arena;
+  }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  ~ArenaScope()
+  {
+    Arena::current() = m_previous;
+  }
+
+private:
+  Arena* m_previous;
+};
+
+struct ArenaStorage
+{
+  template<typename T>
+  static void* allocate(const size_t bytes)
+  {
+    Arena* arena = Arena::current();
+    if(!arena)
+      throw std::logic_error("ArenaStorage used without an ArenaScope");
+
+    return arena->allocate(bytes, alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t));
+  }
+
+  template<typename T>
+  static void deallocate(void*, const size_t) noexcept
+  {
+  }
+};
+
+// whole pages straight from the kernel, for big Arrays that should not fragment the heap
+// and whose memory must go back to the system on destruction; plain heap elsewhere
+struct MmapStorage
+{
+  template<typename T>
+  static void* allocate(const size_t bytes)
+  {
+#ifdef ARRAY_HAS_MMAP
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+      throw std::bad_alloc();
+
+    return memory;
+#else
+    return ::operator new[](bytes);
+#endif
+  }
+
+  template<typename T>
+  static void deallocate(void* memory, const size_t bytes) noexcept
+  {
+#ifdef ARRAY_HAS_MMAP
+    munmap(memory, bytes);
+#else
+    (void)bytes;
+    ::operator delete[](memory);
+#endif
+  }
+};
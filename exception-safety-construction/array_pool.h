@@ -0,0 +1,300 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef> // size_t, std::max_align_t
+#include <cstring> // std::memcpy
+#include <mutex>
+#include <new>
+
+// the pools hand out blocks of POOL_CLASSES power-of-two sizes from POOL_MIN_BLOCK to
+// POOL_MAX_BLOCK bytes, a POOL_HEADER of each holding its size class; bigger requests go to the
+// global heap. Threads take blocks from the shared lists and give them back in batches of
+// about POOL_BATCH_BYTES
+const size_t POOL_HEADER = alignof(std::max_align_t) < sizeof(size_t) ? sizeof(size_t) : alignof(std::max_align_t);
+const size_t POOL_MIN_BLOCK = 32;
+const size_t POOL_MAX_BLOCK = 64 << 10;
+const unsigned POOL_CLASSES = 12;
+const size_t POOL_BATCH_BYTES = 32 << 10;
+const size_t POOL_MAX_BATCH = 64;
+
+namespace detail
+{
+
+// a free block; the first block of a batch also links the batches and counts its blocks
+struct PoolBlock
+{
+  PoolBlock* next;
+  PoolBlock* nextBatch;
+  size_t count;
+};
+
+static_assert(sizeof(PoolBlock) <= POOL_MIN_BLOCK, "a free block does not fit the smallest size class");
+
+inline size_t poolBlockBytes(const unsigned sizeClass)
+{
+  return POOL_MIN_BLOCK << sizeClass;
+}
+
+inline size_t poolBatchBlocks(const unsigned sizeClass)
+{
+  const size_t blocks = POOL_BATCH_BYTES / poolBlockBytes(sizeClass);
+  return blocks < 1 ? 1 : blocks > POOL_MAX_BATCH ? POOL_MAX_BATCH : blocks;
+}
+
+// smallest size class whose blocks hold 'bytes' after the header
+inline unsigned poolSizeClass(const size_t bytes)
+{
+  const size_t total = bytes + POOL_HEADER;
+  if(total <= POOL_MIN_BLOCK)
+    return 0;
+
+  unsigned bits = 0;
+#if defined(__GNUC__)
+  bits = 64 - __builtin_clzll(total - 1);
+#else
+  for(size_t rest = total - 1; rest; rest >>= 1)
+    ++bits;
+#endif
+  return bits - 5;
+}
+
+static_assert(POOL_MIN_BLOCK == 32 && POOL_MAX_BLOCK == POOL_MIN_BLOCK << (POOL_CLASSES - 1),
+              "poolSizeClass assumes 32-byte blocks in the first of POOL_CLASSES classes");
+
+} // namespace detail
+
+// allocator with free lists per size class, separate for every Tag. Allocation and freeing
+// take and give back blocks of the calling thread's cache, without locking; only when a cache
+// runs empty or holds two batches of a class does it trade one batch with the shared lists.
+// Memory freed into a pool stays there for later allocations of the same Tag, it is never
+// returned to the global heap
+template<typename Tag>
+class ObjectPool
+{
+public:
+  static void* allocate(const size_t bytes)
+  {
+    Cache* cache = threadCache();
+    if(bytes > POOL_MAX_BLOCK - POOL_HEADER || !cache)
+      return allocateLarge(bytes);
+
+    const unsigned sizeClass = detail::poolSizeClass(bytes);
+    if(!cache->heads[sizeClass])
+      refill(*cache, sizeClass);
+
+    detail::PoolBlock* block = cache->heads[sizeClass];
+    cache->heads[sizeClass] = block->next;
+    --cache->counts[sizeClass];
+
+    return withHeader(block, sizeClass);
+  }
+
+  static void deallocate(void* memory) noexcept
+  {
+    if(!memory)
+      return;
+
+    char* block = static_cast<char*>(memory) - POOL_HEADER;
+    size_t sizeClass;
+    std::memcpy(&sizeClass, block, sizeof(sizeClass));
+
+    if(sizeClass == POOL_CLASSES)
+    {
+      ::operator delete(block);
+      return;
+    }
+
+    detail::PoolBlock* free = reinterpret_cast<detail::PoolBlock*>(block);
+    Cache* cache = threadCache();
+    if(!cache)
+    {
+      free->next = nullptr;
+      pushBatch(static_cast<unsigned>(sizeClass), free, 1);
+      return;
+    }
+
+    free->next = cache->heads[sizeClass];
+    cache->heads[sizeClass] = free;
+    if(++cache->counts[sizeClass] >= 2 * detail::poolBatchBlocks(static_cast<unsigned>(sizeClass)))
+      release(*cache, static_cast<unsigned>(sizeClass));
+  }
+
+  // calls to the global heap so far: new batches of blocks and requests too big for the pool
+  static size_t heapAllocations()
+  {
+    return state().heapAllocations.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Shared
+  {
+    Shared()
+      : batches(nullptr)
+    {
+    }
+
+    std::mutex mutex;
+    detail::PoolBlock* batches;
+  };
+
+  struct State
+  {
+    State()
+      : heapAllocations(0)
+    {
+    }
+
+    Shared classes[POOL_CLASSES];
+    std::atomic<size_t> heapAllocations;
+  };
+
+  struct Cache
+  {
+    Cache()
+      : alive(true)
+    {
+      for(unsigned c = 0; c < POOL_CLASSES; ++c)
+      {
+        heads[c] = nullptr;
+        counts[c] = 0;
+      }
+    }
+
+    // an exiting thread gives all its blocks back; Arrays destroyed after this, by later
+    // thread-local destructors, go to the shared lists directly
+    ~Cache()
+    {
+      for(unsigned c = 0; c < POOL_CLASSES; ++c)
+        if(heads[c])
+          pushBatch(c, heads[c], counts[c]);
+      alive = false;
+    }
+
+    detail::PoolBlock* heads[POOL_CLASSES];
+    size_t counts[POOL_CLASSES];
+    bool alive;
+  };
+
+  // never destroyed: blocks may be freed by static destructors of other translation units
+  static State& state()
+  {
+    static State* state = new State;
+    return *state;
+  }
+
+  static Cache* threadCache()
+  {
+    static thread_local Cache cache;
+    return cache.alive ? &cache : nullptr;
+  }
+
+  static void* withHeader(void* block, const size_t sizeClass)
+  {
+    std::memcpy(block, &sizeClass, sizeof(sizeClass));
+    return static_cast<char*>(block) + POOL_HEADER;
+  }
+
+  static void* allocateLarge(const size_t bytes)
+  {
+    if(bytes > size_t(-1) - POOL_HEADER)
+      throw std::bad_alloc();
+
+    void* block = ::operator new(bytes + POOL_HEADER);
+    state().heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return withHeader(block, POOL_CLASSES);
+  }
+
+  // a batch from the shared list, or a new one carved out of one heap allocation
+  static void refill(Cache& cache, const unsigned sizeClass)
+  {
+    Shared& shared = state().classes[sizeClass];
+    {
+      std::lock_guard<std::mutex> lock(shared.mutex);
+      if(detail::PoolBlock* batch = shared.batches)
+      {
+        shared.batches = batch->nextBatch;
+        cache.heads[sizeClass] = batch;
+        cache.counts[sizeClass] = batch->count;
+        return;
+      }
+    }
+
+    const size_t blockBytes = detail::poolBlockBytes(sizeClass);
+    const size_t count = detail::poolBatchBlocks(sizeClass);
+    char* chunk = static_cast<char*>(::operator new(blockBytes * count));
+    state().heapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    for(size_t b = 0; b < count; ++b)
+      reinterpret_cast<detail::PoolBlock*>(chunk + b * blockBytes)->next
+        = b + 1 < count ? reinterpret_cast<detail::PoolBlock*>(chunk + (b + 1) * blockBytes) : nullptr;
+
+    cache.heads[sizeClass] = reinterpret_cast<detail::PoolBlock*>(chunk);
+    cache.counts[sizeClass] = count;
+  }
+
+  // hands the first batch of the cache's blocks over to the shared list
+  static void release(Cache& cache, const unsigned sizeClass)
+  {
+    const size_t count = detail::poolBatchBlocks(sizeClass);
+    detail::PoolBlock* first = cache.heads[sizeClass];
+    detail::PoolBlock* last = first;
+    for(size_t b = 1; b < count; ++b)
+      last = last->next;
+
+    cache.heads[sizeClass] = last->next;
+    cache.counts[sizeClass] -= count;
+    last->next = nullptr;
+    pushBatch(sizeClass, first, count);
+  }
+
+  static void pushBatch(const unsigned sizeClass, detail::PoolBlock* first, const size_t count)
+  {
+    Shared& shared = state().classes[sizeClass];
+    first->count = count;
+
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    first->nextBatch = shared.batches;
+    shared.batches = first;
+  }
+};
+
+// base that makes new and new[] of T (and so Array<T> with HeapStorage) allocate from T's own
+// ObjectPool:
+//   struct Foo : PoolAllocated<Foo> { ... };
+// A type that needs to do more in its operator new[], like counting, can call
+// ObjectPool<T>::allocate and deallocate from there instead
+template<typename T>
+struct PoolAllocated
+{
+  void* operator new(const size_t bytes)
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "pooled types must not be over-aligned");
+    return ObjectPool<T>::allocate(bytes);
+  }
+
+  void* operator new[](const size_t bytes)
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "pooled types must not be over-aligned");
+    return ObjectPool<T>::allocate(bytes);
+  }
+
+  void operator delete(void* memory) noexcept
+  {
+    ObjectPool<T>::deallocate(memory);
+  }
+
+  void operator delete[](void* memory) noexcept
+  {
+    ObjectPool<T>::deallocate(memory);
+  }
+
+  // a class operator new hides the placement form Array constructs its elements with
+  void* operator new(size_t, void* place) noexcept
+  {
+    return place;
+  }
+
+  void operator delete(void*, void*) noexcept
+  {
+  }
+};
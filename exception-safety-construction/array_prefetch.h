@@ -0,0 +1,108 @@
+#pragma once
+
+#include "array.h"
+#include "array_intrinsics.h" // detail::prefetchRead
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// how many elements ahead prefetchedCopy requests the heap data of the source
+const size_t COPY_PREFETCH_DISTANCE = 8;
+// at most this many bytes of every element's heap data are prefetched
+const size_t COPY_PREFETCH_BYTES = 256;
+
+// where an element keeps the data its copy has to read; specialize for other pointer-holding
+// types. The default has none, which makes prefetchedCopy a plain copy
+template<typename T>
+struct HeapData
+{
+  static std::pair<const void*, size_t> of(const T&)
+  {
+    return std::pair<const void*, size_t>(nullptr, 0);
+  }
+};
+
+template<typename T, typename BoundsCheck, typename Storage>
+struct HeapData<Array<T, BoundsCheck, Storage> >
+{
+  static std::pair<const void*, size_t> of(const Array<T, BoundsCheck, Storage>& array)
+  {
+    return std::pair<const void*, size_t>(array.data(), array.size() * sizeof(T));
+  }
+};
+
+template<typename C, typename Traits, typename Allocator>
+struct HeapData<std::basic_string<C, Traits, Allocator> >
+{
+  static std::pair<const void*, size_t> of(const std::basic_string<C, Traits, Allocator>& string)
+  {
+    return std::pair<const void*, size_t>(string.data(), string.size() * sizeof(C));
+  }
+};
+
+template<typename T, typename Allocator>
+struct HeapData<std::vector<T, Allocator> >
+{
+  static std::pair<const void*, size_t> of(const std::vector<T, Allocator>& vector)
+  {
+    return std::pair<const void*, size_t>(vector.data(), vector.size() * sizeof(T));
+  }
+};
+
+template<typename T>
+struct HeapData<std::shared_ptr<T> >
+{
+  static std::pair<const void*, size_t> of(const std::shared_ptr<T>& pointer)
+  {
+    return std::pair<const void*, size_t>(pointer.get(), pointer ? sizeof(T) : 0);
+  }
+};
+
+namespace detail
+{
+
+template<typename T>
+void prefetchHeapData(const T& element)
+{
+  const std::pair<const void*, size_t> data = HeapData<T>::of(element);
+  const char* bytes = static_cast<const char*>(data.first);
+  const size_t size = data.second < COPY_PREFETCH_BYTES ? data.second : COPY_PREFETCH_BYTES;
+
+  for(size_t offset = 0; offset < size; offset += 64)
+    prefetchRead(bytes + offset);
+}
+
+} // namespace detail
+
+// copy of 'source' like its copy constructor, but while element i is copied the heap data of
+// element i + distance is already being fetched, so the misses of consecutive elements
+// overlap instead of stalling the loop one after another. Opt-in: it pays off when the
+// elements' heap blocks are scattered, and only costs a few instructions when they are not
+template<typename T, typename BoundsCheck, typename Storage>
+Array<T, BoundsCheck, Storage> prefetchedCopy(const Array<T, BoundsCheck, Storage>& source,
+                                              const size_t distance = COPY_PREFETCH_DISTANCE)
+{
+  const size_t size = source.size();
+  const T* from = source.data();
+
+  Array<T, BoundsCheck, Storage> result(size, Uninitialized());
+  T* out = result.data();
+
+  const size_t ahead = distance < size ? distance : size;
+  for(size_t i = 0; i < ahead; ++i)
+    detail::prefetchHeapData(from[i]);
+
+  size_t i = 0;
+  for(; i + distance < size; ++i)
+  {
+    detail::prefetchHeapData(from[i + distance]);
+    out[i] = from[i];
+  }
+
+  for(; i < size; ++i)
+    out[i] = from[i];
+
+  return result;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// element types whose equality is equality of their bytes: no padding, no float signed zeros or
+// NaNs; specialize for plain structs that qualify to get the memcmp/byte-hash paths
+template<typename T>
+struct IsBitwiseComparable
+  : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value>
+{
+};
+
+// element counts up to which smallFill goes through fully unrolled kernels, in SMALL_CLASSES
+// size classes of 1, 2-3, 4-7, 8-15, 16-31 and 32-64 elements
+const size_t SMALL_KERNEL_LIMIT = 64;
+const unsigned SMALL_CLASSES = 6;
+
+namespace detail
+{
+
+// element I, then the rest up to N, as straight-line code
+template<size_t I, size_t N>
+struct Unrolled
+{
+  template<typename T>
+  static void copy(const T* source, T* destination)
+  {
+    destination[I] = source[I];
+    Unrolled<I + 1, N>::copy(source, destination);
+  }
+
+  template<typename T>
+  static void fill(T* destination, const T& value)
+  {
+    destination[I] = value;
+    Unrolled<I + 1, N>::fill(destination, value);
+  }
+
+  // no early exit, so the comparisons can be done side by side
+  template<typename T>
+  static bool equal(const T* first, const T* second)
+  {
+    return (first[I] == second[I]) & Unrolled<I + 1, N>::equal(first, second);
+  }
+};
+
+template<size_t N>
+struct Unrolled<N, N>
+{
+  template<typename T>
+  static void copy(const T*, T*)
+  {
+  }
+
+  template<typename T>
+  static void fill(T*, const T&)
+  {
+  }
+
+  template<typename T>
+  static bool equal(const T*, const T*)
+  {
+    return true;
+  }
+};
+
+template<typename Word>
+bool equalWords(const unsigned char* first, const unsigned char* second)
+{
+  Word a, b;
+  std::memcpy(&a, first, sizeof(Word));
+  std::memcpy(&b, second, sizeof(Word));
+  return a == b;
+}
+
+// equality of Bytes bytes: the widest loads that fit, the last one overlapping the one before
+template<size_t Bytes>
+bool equalBytes(const unsigned char* first, const unsigned char* second)
+{
+#if defined(__SSE2__)
+  // the differences are or-ed together and tested once at the end
+  if(Bytes >= 16)
+  {
+    __m128i difference = _mm_setzero_si128();
+    for(size_t offset = 0; offset + 16 <= Bytes; offset += 16)
+      difference = _mm_or_si128(difference, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + offset)),
+                                                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + offset))));
+    if(Bytes % 16)
+      difference = _mm_or_si128(difference, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + Bytes - 16)),
+                                                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + Bytes - 16))));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) == 0xFFFF;
+  }
+#endif
+
+  if(Bytes >= 8)
+  {
+    bool same = true;
+    for(size_t offset = 0; offset + 8 <= Bytes; offset += 8)
+      same &= equalWords<uint64_t>(first + offset, second + offset);
+    return same & equalWords<uint64_t>(first + Bytes - 8, second + Bytes - 8);
+  }
+
+  if(Bytes >= 4)
+    return equalWords<uint32_t>(first, second) & equalWords<uint32_t>(first + Bytes - 4, second + Bytes - 4);
+
+  if(Bytes >= 2)
+    return equalWords<uint16_t>(first, second) & equalWords<uint16_t>(first + Bytes - 2, second + Bytes - 2);
+
+  return !Bytes || *first == *second;
+}
+
+// trivially copyable elements are copied as one block of constant size, which the compiler
+// turns into a handful of vector moves; element by element it would have to assume that
+// every store may change the source
+template<size_t N, typename T>
+void copyFixed(const T* source, T* destination, std::true_type)
+{
+  std::memcpy(destination, source, N * sizeof(T));
+}
+
+template<size_t N, typename T>
+void copyFixed(const T* source, T* destination, std::false_type)
+{
+  Unrolled<0, N>::copy(source, destination);
+}
+
+// the value is copied first for the same reason: it may be one of the elements
+template<size_t N, typename T>
+void fillFixed(T* destination, const T& value, std::true_type)
+{
+  const T local = value;
+  Unrolled<0, N>::fill(destination, local);
+}
+
+template<size_t N, typename T>
+void fillFixed(T* destination, const T& value, std::false_type)
+{
+  Unrolled<0, N>::fill(destination, value);
+}
+
+template<size_t N, typename T>
+bool equalFixed(const T* first, const T* second, std::true_type)
+{
+  return equalBytes<N * sizeof(T)>(reinterpret_cast<const unsigned char*>(first),
+                                    reinterpret_cast<const unsigned char*>(second));
+}
+
+template<size_t N, typename T>
+bool equalFixed(const T* first, const T* second, std::false_type)
+{
+  return Unrolled<0, N>::equal(first, second);
+}
+
+} // namespace detail
+
+// kernels for a size known at compile time
+template<size_t N, typename T>
+void copyFixed(const T* source, T* destination)
+{
+  detail::copyFixed<N>(source, destination, std::is_trivially_copyable<T>());
+}
+
+template<size_t N, typename T>
+void fillFixed(T* destination, const T& value)
+{
+  detail::fillFixed<N>(destination, value, std::is_trivially_copyable<T>());
+}
+
+template<size_t N, typename T>
+bool equalFixed(const T* first, const T* second)
+{
+  return detail::equalFixed<N>(first, second, IsBitwiseComparable<T>());
+}
+
+namespace detail
+{
+
+// size class of 1..SMALL_KERNEL_LIMIT elements: the largest power of two not above the count,
+// with the limit itself in the class below
+inline unsigned smallSizeClass(const size_t count)
+{
+  unsigned bit = 0;
+#if defined(__GNUC__)
+  bit = 63 - __builtin_clzll(count);
+#else
+  for(size_t rest = count; rest >>= 1; )
+    ++bit;
+#endif
+  return count == SMALL_KERNEL_LIMIT ? bit - 1 : bit;
+}
+
+// a count in [K, 2K] is covered by two kernels of K elements, one from the front and one
+// from the back, overlapping in the middle; the overlapped elements are written twice with
+// the same value, which is only allowed for trivially copyable elements
+template<size_t K, typename T>
+void fillClass(T* destination, const size_t count, const T& value)
+{
+  ::fillFixed<K>(destination, value);
+  ::fillFixed<K>(destination + count - K, value);
+}
+
+} // namespace detail
+
+// std::fill for runtime sizes of trivially copyable elements: up to SMALL_KERNEL_LIMIT elements
+// a switch on the size class (a jump table) picks the unrolled kernels, above that and for
+// other elements it is std::fill. Copy and compare have no such front end, the same dispatch
+// measured slower than std::copy and std::equal
+template<typename T>
+void smallFill(T* destination, const size_t count, const T& value)
+{
+  if(!std::is_trivially_copyable<T>::value || count > SMALL_KERNEL_LIMIT)
+  {
+    std::fill(destination, destination + count, value);
+    return;
+  }
+
+  switch(count ? detail::smallSizeClass(count) : SMALL_CLASSES)
+  {
+  case 0: fillFixed<1>(destination, value); break;
+  case 1: detail::fillClass<2>(destination, count, value); break;
+  case 2: detail::fillClass<4>(destination, count, value); break;
+  case 3: detail::fillClass<8>(destination, count, value); break;
+  case 4: detail::fillClass<16>(destination, count, value); break;
+  case 5: detail::fillClass<32>(destination, count, value); break;
+  default: break;
+  }
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "array.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <functional> // std::less
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// below these sizes the parallel kernels fall back to the standard algorithms
+const size_t RADIX_SORT_THRESHOLD = 2048;
+const size_t PARALLEL_SORT_GRAIN = 1 << 16;
+const size_t PARALLEL_MERGE_GRAIN = 1 << 15;
+
+namespace detail
+{
+
+// maps an arithmetic key to an unsigned integer with the same ordering
+template<typename T, typename Enable = void>
+struct RadixTraits
+{
+  static const bool enabled = false;
+};
+
+template<typename T>
+struct RadixTraits<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+{
+  static const bool enabled = true;
+  typedef typename std::make_unsigned<T>::type Key;
+
+  static Key key(const T value)
+  {
+    const Key signBit = static_cast<Key>(Key(1) << (sizeof(Key) * 8 - 1));
+    return std::is_signed<T>::value ? static_cast<Key>(static_cast<Key>(value) ^ signBit) : static_cast<Key>(value);
+  }
+};
+
+template<>
+struct RadixTraits<float>
+{
+  static const bool enabled = true;
+  typedef uint32_t Key;
+
+  static Key key(const float value)
+  {
+    Key bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+};
+
+template<>
+struct RadixTraits<double>
+{
+  static const bool enabled = true;
+  typedef uint64_t Key;
+
+  static Key key(const double value)
+  {
+    Key bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+  }
+};
+
+// LSD radix sort of [source, source + size) using 'buffer' as scratch, 8 bits per pass;
+// the sorted data ends up in 'source'
+template<typename T>
+void radixSort(T* source, T* buffer, const size_t size, const size_t threads)
+{
+  typedef RadixTraits<T> Traits;
+  const size_t BUCKETS = 256;
+
+  Array<size_t> counts(threads * BUCKETS);
+  T* from = source;
+  T* to = buffer;
+
+  for(size_t shift = 0; shift < sizeof(typename Traits::Key) * 8; shift += 8)
+  {
+    std::fill(counts.begin(), counts.end(), size_t(0));
+
+    parallelFor(size, threads, [&](const size_t thread, const size_t begin, const size_t end)
+    {
+      size_t* local = counts.data() + thread * BUCKETS;
+      for(size_t i = begin; i < end; ++i)
+        ++local[(Traits::key(from[i]) >> shift) & 0xff];
+    });
+
+    // a digit shared by every element does not reorder anything
+    bool trivial = false;
+    size_t offset = 0;
+    for(size_t digit = 0; digit < BUCKETS; ++digit)
+    {
+      size_t total = 0;
+      for(size_t thread = 0; thread < threads; ++thread)
+      {
+        size_t& count = counts[thread * BUCKETS + digit];
+        const size_t current = count;
+        count = offset + total;
+        total += current;
+      }
+      trivial = trivial || total == size;
+      offset += total;
+    }
+
+    if(trivial)
+      continue;
+
+    parallelFor(size, threads, [&](const size_t thread, const size_t begin, const size_t end)
+    {
+      size_t* local = counts.data() + thread * BUCKETS;
+      for(size_t i = begin; i < end; ++i)
+        to[local[(Traits::key(from[i]) >> shift) & 0xff]++] = from[i];
+    });
+
+    std::swap(from, to);
+  }
+
+  if(from != source)
+    std::copy(from, from + size, source);
+}
+
+// number of elements taken from 'first' among the first 'diagonal' elements of the stable
+// merge of 'first' and 'second' (merge path split)
+template<typename T, typename Compare>
+size_t mergeSplit(const T* first, const size_t firstSize, const T* second, const size_t secondSize,
+                  const size_t diagonal, Compare less)
+{
+  size_t low = diagonal > secondSize ? diagonal - secondSize : 0;
+  size_t high = std::min(diagonal, firstSize);
+
+  while(low < high)
+  {
+    const size_t middle = low + (high - low) / 2;
+    if(less(second[diagonal - middle - 1], first[middle]))
+      high = middle;
+    else
+      low = middle + 1;
+  }
+
+  return low;
+}
+
+// stable merge of two sorted ranges into 'out', the output is cut into 'threads' equal
+// slices and each slice finds its inputs by a merge path search
+template<typename T, typename Compare>
+void parallelMerge(const T* first, const size_t firstSize, const T* second, const size_t secondSize,
+                   T* out, Compare less, const size_t threads)
+{
+  const size_t total = firstSize + secondSize;
+
+  parallelFor(total, threads, [&](const size_t, const size_t begin, const size_t end)
+  {
+    const size_t firstBegin = mergeSplit(first, firstSize, second, secondSize, begin, less);
+    const size_t firstEnd = mergeSplit(first, firstSize, second, secondSize, end, less);
+
+    std::merge(first + firstBegin, first + firstEnd,
+               second + (begin - firstBegin), second + (end - firstEnd),
+               out + begin, less);
+  });
+}
+
+} // namespace detail
+
+// sorts arithmetic keys with a parallel LSD radix sort, other types go to std::sort. Like the
+// other parallel kernels it picks its thread count from the size and hardwareThreads() unless
+// 'threads' is given
+template<typename T>
+typename std::enable_if<detail::RadixTraits<T>::enabled>::type parallelSort(Array<T>& array, const size_t threads = 0)
+{
+  const size_t size = array.size();
+  if(size < RADIX_SORT_THRESHOLD)
+  {
+    std::sort(array.begin(), array.end());
+    return;
+  }
+
+  Array<T> buffer(size, Uninitialized());
+  detail::radixSort(array.data(), buffer.data(), size, parallelThreadCount(size, PARALLEL_SORT_GRAIN, threads));
+}
+
+template<typename T>
+typename std::enable_if<!detail::RadixTraits<T>::enabled>::type parallelSort(Array<T>& array, const size_t = 0)
+{
+  std::sort(array.begin(), array.end());
+}
+
+// stable parallel merge sort: every thread std::stable_sort's its chunk, then the chunks are
+// merged pairwise with all threads working on each merge
+template<typename T, typename Compare>
+void parallelStableSort(Array<T>& array, Compare less, const size_t sortThreads = 0)
+{
+  const size_t size = array.size();
+  const size_t threads = parallelThreadCount(size, PARALLEL_SORT_GRAIN, sortThreads);
+
+  if(threads == 1)
+  {
+    std::stable_sort(array.begin(), array.end(), less);
+    return;
+  }
+
+  parallelFor(size, threads, [&](const size_t, const size_t begin, const size_t end)
+  {
+    std::stable_sort(array.data() + begin, array.data() + end, less);
+  });
+
+  Array<T> buffer(size, Uninitialized());
+  T* from = array.data();
+  T* to = buffer.data();
+  const size_t mergeThreads = parallelThreadCount(size, PARALLEL_MERGE_GRAIN, sortThreads);
+
+  for(size_t width = 1; width < threads; width *= 2)
+  {
+    for(size_t chunk = 0; chunk < threads; chunk += 2 * width)
+    {
+      const size_t begin = partitionBegin(size, threads, chunk);
+      const size_t middle = partitionBegin(size, threads, std::min(chunk + width, threads));
+      const size_t end = partitionBegin(size, threads, std::min(chunk + 2 * width, threads));
+
+      if(middle == end)
+        std::copy(from + begin, from + end, to + begin);
+      else
+        detail::parallelMerge(from + begin, middle - begin, from + middle, end - middle, to + begin, less, mergeThreads);
+    }
+
+    std::swap(from, to);
+  }
+
+  if(from != array.data())
+    std::copy(from, from + size, array.data());
+}
+
+template<typename T>
+void parallelStableSort(Array<T>& array)
+{
+  parallelStableSort(array, std::less<T>());
+}
+
+namespace detail
+{
+
+// the branchless search stops once this many candidates are left and counts them instead
+const size_t LINEAR_SEARCH_SIZE = 16;
+
+template<typename T>
+size_t countLess(const T* first, const size_t size, const T& value)
+{
+  size_t count = 0;
+  for(size_t i = 0; i < size; ++i)
+    count += first[i] < value;
+  return count;
+}
+
+#if defined(__SSE2__)
+inline size_t countLess(const int* first, const size_t size, const int& value)
+{
+  const __m128i key = _mm_set1_epi32(value);
+  size_t count = 0;
+  size_t i = 0;
+
+  for(; i + 4 <= size; i += 4)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+    count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(block, key))));
+  }
+
+  for(; i < size; ++i)
+    count += first[i] < value;
+
+  return count;
+}
+
+inline size_t countLess(const double* first, const size_t size, const double& value)
+{
+  const __m128d key = _mm_set1_pd(value);
+  size_t count = 0;
+  size_t i = 0;
+
+  for(; i + 2 <= size; i += 2)
+    count += __builtin_popcount(_mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(first + i), key)));
+
+  for(; i < size; ++i)
+    count += first[i] < value;
+
+  return count;
+}
+#endif
+
+} // namespace detail
+
+// index of the first element not less than 'value' in a sorted array; the halving loop has
+// no data-dependent branches and the last few candidates are counted with SIMD compares
+template<typename T>
+size_t lowerBound(const Array<T>& array, const T& value)
+{
+  const T* first = array.data();
+  const T* base = first;
+  size_t length = array.size();
+
+  // the answer always stays within [base, base + length]
+  while(length > detail::LINEAR_SEARCH_SIZE)
+  {
+    const size_t half = length / 2;
+#if defined(__GNUC__)
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+#endif
+    base = (base[half] < value) ? base + half : base;
+    length -= half;
+  }
+
+  return static_cast<size_t>(base - first) + detail::countLess(base, length, value);
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "array_small.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// copies and fills of at least this many bytes bypass the cache with non-temporal stores, so a
+// huge streamingCopy or Array::fill does not evict the rest of the process' working set;
+// roughly the size of a last-level cache, override with -DARRAY_STREAMING_THRESHOLD=<bytes>
+#ifndef ARRAY_STREAMING_THRESHOLD
+#define ARRAY_STREAMING_THRESHOLD (16 << 20)
+#endif
+
+const size_t STREAMING_THRESHOLD = ARRAY_STREAMING_THRESHOLD;
+
+namespace detail
+{
+
+#if defined(__SSE2__)
+const size_t STREAM_ALIGNMENT = 16;
+
+// bytes up to the next 16-byte boundary of 'destination', capped at 'bytes'
+inline size_t streamHead(const void* destination, const size_t bytes)
+{
+  const size_t misalignment = reinterpret_cast<uintptr_t>(destination) & (STREAM_ALIGNMENT - 1);
+  const size_t head = misalignment ? STREAM_ALIGNMENT - misalignment : 0;
+  return head < bytes ? head : bytes;
+}
+
+// plain copy of the unaligned head and tail, non-temporal 16-byte stores in between; the
+// sfence orders the weakly-ordered streaming stores before anything that follows
+inline void streamCopyBytes(void* destination, const void* source, const size_t bytes)
+{
+  char* out = static_cast<char*>(destination);
+  const char* in = static_cast<const char*>(source);
+
+  const size_t head = streamHead(out, bytes);
+  std::memcpy(out, in, head);
+
+  size_t i = head;
+  for(; i + 4 * STREAM_ALIGNMENT <= bytes; i += 4 * STREAM_ALIGNMENT)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 16));
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 32));
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i), a);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i + 16), b);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i + 32), c);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i + 48), d);
+  }
+
+  for(; i + STREAM_ALIGNMENT <= bytes; i += STREAM_ALIGNMENT)
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+
+  std::memcpy(out + i, in + i, bytes - i);
+  _mm_sfence();
+}
+
+// 'pattern' holds 16 bytes of repeated elements, the first starting at 'destination'. Elements
+// may be aligned to less than their size, so the 16-byte boundaries can fall inside them: the
+// aligned stores take the pattern rotated by the head, which lines it up again as the element
+// size divides 16
+inline void streamFillBytes(void* destination, const __m128i pattern, const size_t bytes)
+{
+  char* out = static_cast<char*>(destination);
+
+  alignas(16) char bytesOfPattern[STREAM_ALIGNMENT];
+  _mm_store_si128(reinterpret_cast<__m128i*>(bytesOfPattern), pattern);
+
+  const size_t head = streamHead(out, bytes);
+  std::memcpy(out, bytesOfPattern, head);
+
+  alignas(16) char rotated[STREAM_ALIGNMENT];
+  for(size_t b = 0; b < STREAM_ALIGNMENT; ++b)
+    rotated[b] = bytesOfPattern[(head + b) % STREAM_ALIGNMENT];
+  const __m128i aligned = _mm_load_si128(reinterpret_cast<const __m128i*>(rotated));
+
+  size_t i = head;
+  for(; i + STREAM_ALIGNMENT <= bytes; i += STREAM_ALIGNMENT)
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + i), aligned);
+
+  std::memcpy(out + i, rotated, bytes - i);
+  _mm_sfence();
+}
+#endif
+
+template<typename T>
+struct IsStreamable : std::integral_constant<bool, std::is_trivially_copyable<T>::value>
+{
+};
+
+// element sizes that tile a 16-byte pattern
+template<typename T>
+struct IsStreamFillable : std::integral_constant<bool, IsStreamable<T>::value && sizeof(T) <= 16 && !(16 % sizeof(T))>
+{
+};
+
+template<typename T>
+void streamingCopy(const T* source, T* destination, const size_t count, std::true_type)
+{
+#if defined(__SSE2__)
+  if(count * sizeof(T) >= STREAMING_THRESHOLD)
+  {
+    streamCopyBytes(destination, source, count * sizeof(T));
+    return;
+  }
+#endif
+
+  std::copy(source, source + count, destination);
+}
+
+template<typename T>
+void streamingCopy(const T* source, T* destination, const size_t count, std::false_type)
+{
+  std::copy(source, source + count, destination);
+}
+
+template<typename T>
+void streamingFill(T* destination, const size_t count, const T& value, std::true_type)
+{
+#if defined(__SSE2__)
+  if(count * sizeof(T) >= STREAMING_THRESHOLD)
+  {
+    alignas(16) char pattern[STREAM_ALIGNMENT];
+    for(size_t offset = 0; offset < STREAM_ALIGNMENT; offset += sizeof(T))
+      std::memcpy(pattern + offset, &value, sizeof(T));
+
+    streamFillBytes(destination, _mm_load_si128(reinterpret_cast<const __m128i*>(pattern)), count * sizeof(T));
+    return;
+  }
+#endif
+
+  smallFill(destination, count, value);
+}
+
+template<typename T>
+void streamingFill(T* destination, const size_t count, const T& value, std::false_type)
+{
+  std::fill(destination, destination + count, value);
+}
+
+} // namespace detail
+
+// std::copy that streams past the cache for large trivially copyable ranges
+template<typename T>
+void streamingCopy(const T* source, T* destination, const size_t count)
+{
+  detail::streamingCopy(source, destination, count, detail::IsStreamable<T>());
+}
+
+// std::fill that streams past the cache for large trivially copyable ranges
+template<typename T>
+void streamingFill(T* destination, const size_t count, const T& value)
+{
+  detail::streamingFill(destination, count, value, detail::IsStreamFillable<T>());
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+// build with -DARRAY_TRACE=1 to have every Array record when it is built, copied and freed;
+// otherwise the hooks in array.h compile to nothing
+#ifndef ARRAY_TRACE
+#define ARRAY_TRACE 0
+#endif
+
+// events each thread can hold between two dumps, further events are dropped and counted
+#ifndef ARRAY_TRACE_RING_EVENTS
+#define ARRAY_TRACE_RING_EVENTS (1 << 16)
+#endif
+
+#if ARRAY_TRACE
+#define ARRAY_TRACE_EVENT(op, size, ...) ArrayTracer::record<__VA_ARGS__>(op, size)
+#else
+#define ARRAY_TRACE_EVENT(op, size, ...) ((void)0)
+#endif
+
+enum class TraceOp : uint8_t
+{
+  Create,
+  Copy,
+  Destroy
+};
+
+struct TraceEvent
+{
+  uint64_t timestampNs;
+  uint64_t size;
+  uint32_t typeId;
+  TraceOp op;
+};
+
+namespace detail
+{
+
+// the ring of one thread at a time: its thread is the only producer, dumps are the only
+// consumer and run one at a time, so head and tail are enough to hand events over without a
+// lock. When the thread exits the ring is released, with the events it still holds, and the
+// next new thread takes it over
+struct TraceRing
+{
+  static const size_t CAPACITY = ARRAY_TRACE_RING_EVENTS;
+  static const size_t CACHE_LINE = 64;
+
+  explicit TraceRing(const uint32_t thread)
+    : events(new TraceEvent[CAPACITY])
+    , thread(thread)
+    , dropped(0)
+    , owned(true)
+    , head(0)
+    , tail(0)
+  {
+  }
+
+  void push(const TraceEvent& event)
+  {
+    const size_t position = tail.load(std::memory_order_relaxed);
+    if(position - head.load(std::memory_order_acquire) == CAPACITY)
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    events[position % CAPACITY] = event;
+    tail.store(position + 1, std::memory_order_release);
+  }
+
+  const std::unique_ptr<TraceEvent[]> events;
+  // the track of the ring in the dump, shared by the threads that owned it one after another
+  const uint32_t thread;
+  std::atomic<uint64_t> dropped;
+  std::atomic<bool> owned;
+
+  // padding rather than alignas: plain new does not honour over-alignment before C++17, while
+  // a full cache line between them keeps head and tail apart at any address
+  char beforeHead[CACHE_LINE];
+  // consumer owned
+  std::atomic<size_t> head;
+  char beforeTail[CACHE_LINE - sizeof(std::atomic<size_t>)];
+  // producer owned
+  std::atomic<size_t> tail;
+};
+
+} // namespace detail
+
+// per-thread rings of fixed-size Array lifecycle events, dumped in the Chrome trace event
+// format (chrome://tracing, Perfetto). The rings of exited threads are reused, so there are
+// only as many as threads ever ran at the same time. Recording takes a clock read and a store
+// into the ring of the calling thread; only the first event of a thread and of an element type
+// lock
+class ArrayTracer
+{
+public:
+  template<typename T>
+  static void record(const TraceOp op, const size_t size) noexcept
+  {
+    record(op, size, typeId<T>());
+  }
+
+  static void record(const TraceOp op, const size_t size, const uint32_t typeId) noexcept
+  {
+    detail::TraceRing* ring = threadRing();
+    if(!ring)
+      return;
+
+    TraceEvent event;
+    event.timestampNs = now();
+    event.size = size;
+    event.typeId = typeId;
+    event.op = op;
+    ring->push(event);
+  }
+
+  // small number standing for T in the events, its name goes into the dump
+  template<typename T>
+  static uint32_t typeId() noexcept
+  {
+    static const uint32_t id = registerType(typeid(T).name());
+    return id;
+  }
+
+  // writes the events recorded since the last dump as instant events, one track per ring,
+  // and removes them from the rings; returns how many were written
+  static size_t dumpChromeTrace(std::ostream& out)
+  {
+    State& state = instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    const char* const names[] = { "create", "copy", "destroy" };
+    size_t written = 0;
+    uint64_t dropped = 0;
+    out << "{\"traceEvents\":[";
+
+    for(size_t r = 0; r < state.rings.size(); ++r)
+    {
+      detail::TraceRing& ring = *state.rings[r];
+      dropped += ring.dropped.exchange(0, std::memory_order_relaxed);
+
+      const size_t tail = ring.tail.load(std::memory_order_acquire);
+      size_t head = ring.head.load(std::memory_order_relaxed);
+      for(; head != tail; ++head, ++written)
+      {
+        const TraceEvent& event = ring.events[head % detail::TraceRing::CAPACITY];
+        const uint64_t sinceStart = event.timestampNs - state.startNs;
+
+        // ts is in microseconds, printed with all three nanosecond digits
+        out << (written ? ",\n" : "\n") << "{\"name\":\"" << names[static_cast<int>(event.op)]
+            << "\",\"cat\":\"Array\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << ring.thread
+            << ",\"ts\":" << sinceStart / 1000 << "." << pad3(sinceStart % 1000)
+            << ",\"args\":{\"size\":" << event.size << ",\"type\":\"" << escape(typeName(state, event.typeId))
+            << "\"}}";
+      }
+
+      ring.head.store(head, std::memory_order_release);
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << dropped << "}}\n";
+    return written;
+  }
+
+  // throws away the events recorded so far
+  static void clear()
+  {
+    State& state = instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    for(size_t r = 0; r < state.rings.size(); ++r)
+    {
+      state.rings[r]->head.store(state.rings[r]->tail.load(std::memory_order_acquire), std::memory_order_release);
+      state.rings[r]->dropped.store(0, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  struct State
+  {
+    State()
+      : startNs(now())
+    {
+    }
+
+    std::mutex mutex;
+    const uint64_t startNs;
+    std::vector<std::unique_ptr<detail::TraceRing> > rings;
+    std::vector<std::string> types;
+  };
+
+  // never destroyed: Arrays are freed by other static destructors and at thread exit, and
+  // their events must still find the rings
+  static State& instance()
+  {
+    static State* state = new State;
+    return *state;
+  }
+
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // releases the ring of a thread when it exits; events of Arrays destroyed after that, by
+  // later thread-local destructors, are not recorded
+  struct RingOwner
+  {
+    RingOwner()
+      : ring(nullptr)
+      , exited(false)
+    {
+    }
+
+    ~RingOwner()
+    {
+      if(ring)
+        ring->owned.store(false, std::memory_order_release);
+      ring = nullptr;
+      exited = true;
+    }
+
+    detail::TraceRing* ring;
+    bool exited;
+  };
+
+  static detail::TraceRing* threadRing() noexcept
+  {
+    static thread_local RingOwner owner;
+    if(owner.ring || owner.exited)
+      return owner.ring;
+
+    try
+    {
+      State& state = instance();
+      std::lock_guard<std::mutex> lock(state.mutex);
+
+      // the ring of a thread that is gone, or a new one
+      for(size_t r = 0; r < state.rings.size() && !owner.ring; ++r)
+        if(!state.rings[r]->owned.load(std::memory_order_acquire))
+        {
+          state.rings[r]->owned.store(true, std::memory_order_relaxed);
+          owner.ring = state.rings[r].get();
+        }
+
+      if(!owner.ring)
+      {
+        std::unique_ptr<detail::TraceRing> created(new detail::TraceRing(static_cast<uint32_t>(state.rings.size())));
+        state.rings.push_back(std::move(created));
+        owner.ring = state.rings.back().get();
+      }
+    }
+    catch(...)
+    {
+      // no memory for a ring: this thread records nothing
+    }
+
+    return owner.ring;
+  }
+
+  static uint32_t registerType(const char* mangled) noexcept
+  {
+    try
+    {
+      std::string name = mangled;
+#if defined(__GNUG__)
+      int status = 0;
+      char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+      if(demangled)
+      {
+        name = demangled;
+        std::free(demangled);
+      }
+#endif
+
+      State& state = instance();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.types.push_back(name);
+      return static_cast<uint32_t>(state.types.size());
+    }
+    catch(...)
+    {
+      return 0;
+    }
+  }
+
+  static const std::string& typeName(const State& state, const uint32_t id)
+  {
+    static const std::string unknown = "?";
+    return id && id <= state.types.size() ? state.types[id - 1] : unknown;
+  }
+
+  static std::string escape(const std::string& text)
+  {
+    std::string escaped;
+    for(size_t i = 0; i < text.size(); ++i)
+    {
+      if(text[i] == '"' || text[i] == '\\')
+        escaped += '\\';
+      escaped += text[i];
+    }
+    return escaped;
+  }
+
+  static std::string pad3(const uint64_t value)
+  {
+    std::string digits = std::to_string(value);
+    return std::string(3 - digits.size(), '0') + digits;
+  }
+};
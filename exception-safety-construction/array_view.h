@@ -0,0 +1,80 @@
+#pragma once
+
+#include "array.h"
+
+// non-owning window onto contiguous elements, e.g. one row of a JaggedArray;
+// ArrayView<const T> is the read-only flavour
+template<typename T>
+class ArrayView
+{
+public:
+  ArrayView()
+    : m_data(nullptr)
+    , m_size(0)
+  {
+  }
+
+  ArrayView(T* data, const size_t size)
+    : m_data(data)
+    , m_size(size)
+  {
+  }
+
+  template<typename U, typename BoundsCheck, typename Storage>
+  ArrayView(Array<U, BoundsCheck, Storage>& array)
+    : m_data(array.data())
+    , m_size(array.size())
+  {
+  }
+
+  template<typename U, typename BoundsCheck, typename Storage>
+  ArrayView(const Array<U, BoundsCheck, Storage>& array)
+    : m_data(array.data())
+    , m_size(array.size())
+  {
+  }
+
+  // ArrayView<T> -> ArrayView<const T>
+  template<typename U>
+  ArrayView(const ArrayView<U>& other)
+    : m_data(other.data())
+    , m_size(other.size())
+  {
+  }
+
+  const size_t size() const
+  {
+    return m_size;
+  }
+
+  bool empty() const
+  {
+    return !m_size;
+  }
+
+  T& operator [](const size_t index) const
+  {
+    assert(index < m_size);
+
+    return m_data[index];
+  }
+
+  T* data() const
+  {
+    return m_data;
+  }
+
+  T* begin() const
+  {
+    return m_data;
+  }
+
+  T* end() const
+  {
+    return m_data + m_size;
+  }
+
+private:
+  T* m_data;
+  size_t m_size;
+};
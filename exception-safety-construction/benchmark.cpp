@@ -0,0 +1,1348 @@
+#include "array.h"
+#include "array_alloc_profile.h"
+#include "array_compressed.h"
+#include "array_frozen.h"
+#include "array_hash.h"
+#include "array_histogram.h"
+#include "array_incremental.h"
+#include "array_merge.h"
+#include "array_numa.h"
+#include "array_permute.h"
+#include "array_pool.h"
+#include "array_prefetch.h"
+#include "array_small.h"
+#include "array_sort.h"
+#include "benchmark.h"
+#include "benchmark_baseline.h"
+#include "flat_hash_map.h"
+#include "jagged_array.h"
+#include "slot_map.h"
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+
+const size_t SORT_SIZE = 1 << 20;
+const size_t SEARCH_QUERIES = 1 << 20;
+const size_t REPETITIONS = 5;
+
+template<typename T>
+Array<T> randomArray(const size_t size, const unsigned seed)
+{
+  std::mt19937_64 engine(seed);
+  std::uniform_int_distribution<long long> distribution(-1000000000, 1000000000);
+
+  Array<T> array(size);
+  for(size_t i = 0; i < size; ++i)
+    array[i] = static_cast<T>(distribution(engine));
+  return array;
+}
+
+template<typename T>
+void benchmarkSort(BenchmarkRunner& runner, const std::string& type)
+{
+  const Array<T> input = randomArray<T>(SORT_SIZE, 1);
+  Array<T> work;
+
+  runner.run("std::sort " + type, REPETITIONS, [&]() { work = input; },
+             [&]() { std::sort(work.begin(), work.end()); });
+  runner.run("parallelSort " + type, REPETITIONS, [&]() { work = input; },
+             [&]() { parallelSort(work); });
+}
+
+void benchmarkStableSort(BenchmarkRunner& runner)
+{
+  typedef std::pair<int, int> Record;
+
+  const Array<int> keys = randomArray<int>(SORT_SIZE, 2);
+  Array<Record> input(SORT_SIZE);
+  for(size_t i = 0; i < input.size(); ++i)
+    input[i] = Record(keys[i] % 1000, static_cast<int>(i));
+
+  const auto byKey = [](const Record& left, const Record& right) { return left.first < right.first; };
+  Array<Record> work;
+
+  runner.run("std::stable_sort pair<int,int>", REPETITIONS, [&]() { work = input; },
+             [&]() { std::stable_sort(work.begin(), work.end(), byKey); });
+  runner.run("parallelStableSort pair<int,int>", REPETITIONS, [&]() { work = input; },
+             [&]() { parallelStableSort(work, byKey); });
+}
+
+template<typename T>
+void benchmarkSearch(BenchmarkRunner& runner, const std::string& type)
+{
+  Array<T> sorted = randomArray<T>(SORT_SIZE, 3);
+  parallelSort(sorted);
+  const Array<T> queries = randomArray<T>(SEARCH_QUERIES, 4);
+
+  runner.run("std::lower_bound " + type, REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < queries.size(); ++i)
+      sum += std::lower_bound(sorted.begin(), sorted.end(), queries[i]) - sorted.begin();
+    doNotOptimize(sum);
+  });
+  runner.run("lowerBound " + type, REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < queries.size(); ++i)
+      sum += lowerBound(sorted, queries[i]);
+    doNotOptimize(sum);
+  });
+}
+
+void benchmarkMerge(BenchmarkRunner& runner)
+{
+  const size_t SHARDS = 32;
+
+  Array<Array<int> > shards(SHARDS);
+  for(size_t s = 0; s < SHARDS; ++s)
+  {
+    shards[s] = randomArray<int>(SORT_SIZE / SHARDS, 10 + s);
+    std::sort(shards[s].begin(), shards[s].end());
+  }
+
+  runner.run("concatenate + std::sort 32 shards", REPETITIONS, [&]()
+  {
+    Array<int> all(SORT_SIZE, Uninitialized());
+    int* out = all.data();
+    for(size_t s = 0; s < SHARDS; ++s)
+      out = std::copy(shards[s].begin(), shards[s].end(), out);
+    std::sort(all.begin(), all.end());
+    doNotOptimize(all.data());
+  });
+  runner.run("kWayMerge 32 shards", REPETITIONS, [&]()
+  {
+    Array<int> all = kWayMerge(shards);
+    doNotOptimize(all.data());
+  });
+
+  const Array<int>& first = shards[0];
+  const Array<int>& second = shards[1];
+
+  runner.run("std::set_union into presized Array", REPETITIONS, [&]()
+  {
+    Array<int> out(first.size() + second.size(), Uninitialized());
+    doNotOptimize(std::set_union(first.begin(), first.end(), second.begin(), second.end(), out.begin()));
+  });
+  runner.run("setUnion", REPETITIONS, [&]() { doNotOptimize(setUnion(first, second).data()); });
+  runner.run("setIntersection", REPETITIONS, [&]() { doNotOptimize(setIntersection(first, second).data()); });
+  runner.run("setDifference", REPETITIONS, [&]() { doNotOptimize(setDifference(first, second).data()); });
+}
+
+template<typename T>
+void benchmarkPermute(BenchmarkRunner& runner, const std::string& type)
+{
+  const size_t SIZE = 1 << 22;
+
+  Array<unsigned> permutation(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+    permutation[i] = static_cast<unsigned>(i);
+  std::shuffle(permutation.begin(), permutation.end(), std::mt19937(5));
+
+  const Array<T> source = randomArray<T>(SIZE, 6);
+  Array<T> work;
+
+  runner.run("operator[] gather " + type, REPETITIONS, [&]()
+  {
+    Array<T> out(SIZE);
+    Array<T>& from = const_cast<Array<T>&>(source);
+    for(size_t i = 0; i < SIZE; ++i)
+      out[i] = from[permutation[i]];
+    doNotOptimize(out.data());
+  });
+  runner.run("gather " + type, REPETITIONS, [&]() { doNotOptimize(gather(source, permutation).data()); });
+  runner.run("scatter " + type, REPETITIONS, [&]() { work = Array<T>(SIZE, Uninitialized()); },
+             [&]() { scatter(source, permutation, work); });
+  runner.run("applyPermutation " + type, REPETITIONS, [&]() { work = source; },
+             [&]() { applyPermutation(work, permutation); });
+  runner.run("applyPermutationInPlace " + type, REPETITIONS, [&]() { work = source; },
+             [&]() { applyPermutationInPlace(work, permutation); });
+}
+
+void benchmarkHistogram(BenchmarkRunner& runner, const std::string& distribution, const Array<int>& values, const int bins)
+{
+  runner.run("single-bin-array histogram " + distribution, REPETITIONS, [&]()
+  {
+    Array<size_t> counts(bins);
+    for(size_t i = 0; i < values.size(); ++i)
+      if(values[i] >= 0 && values[i] < bins)
+        ++counts[values[i]];
+    doNotOptimize(counts.data());
+  });
+  runner.run("countValues " + distribution, REPETITIONS, [&]()
+  {
+    doNotOptimize(countValues(values, 0, bins - 1).data());
+  });
+}
+
+void benchmarkHistograms(BenchmarkRunner& runner)
+{
+  const size_t SIZE = 1 << 24;
+  std::mt19937 engine(7);
+
+  for(int bins = 256; bins <= 65536; bins *= 256)
+  {
+    const std::string suffix = std::to_string(bins) + " bins";
+
+    Array<int> uniform(SIZE, Uninitialized());
+    std::uniform_int_distribution<int> flat(0, bins - 1);
+    for(size_t i = 0; i < SIZE; ++i)
+      uniform[i] = flat(engine);
+    benchmarkHistogram(runner, "uniform " + suffix, uniform, bins);
+
+    // most values hit a handful of bins, the worst case for a single counter array
+    Array<int> skewed(SIZE, Uninitialized());
+    std::geometric_distribution<int> steep(0.5);
+    for(size_t i = 0; i < SIZE; ++i)
+      skewed[i] = std::min(steep(engine), bins - 1);
+    benchmarkHistogram(runner, "skewed " + suffix, skewed, bins);
+
+    Array<int> constant(SIZE);
+    benchmarkHistogram(runner, "constant " + suffix, constant, bins);
+  }
+}
+
+void benchmarkHash(BenchmarkRunner& runner)
+{
+  const size_t SIZE = 1 << 22;
+  const size_t SET_ARRAYS = 64;
+  const size_t SET_ARRAY_SIZE = 1 << 14;
+
+  const Array<int> values = randomArray<int>(SIZE, 8);
+  const Array<int> copy = values;
+
+  runner.run("element loop equality int", REPETITIONS, [&]()
+  {
+    bool equal = true;
+    for(size_t i = 0; i < SIZE; ++i)
+      equal = equal && values[i] == copy[i];
+    doNotOptimize(equal);
+  });
+  runner.run("Array operator== int", REPETITIONS, [&]() { doNotOptimize(values == copy); });
+  runner.run("hashArray int", REPETITIONS, [&]() { doNotOptimize(hashArray(values)); });
+
+  std::unordered_set<Array<int> > plain;
+  std::unordered_set<HashedArray<int> > hashed;
+  Array<Array<int> > queries(SET_ARRAYS);
+  Array<HashedArray<int> > hashedQueries(SET_ARRAYS);
+  for(size_t i = 0; i < SET_ARRAYS; ++i)
+  {
+    queries[i] = randomArray<int>(SET_ARRAY_SIZE, 100 + i);
+    hashedQueries[i] = HashedArray<int>(queries[i]);
+    plain.insert(queries[i]);
+    hashed.insert(hashedQueries[i]);
+  }
+
+  runner.run("unordered_set<Array> lookups", REPETITIONS, [&]()
+  {
+    size_t found = 0;
+    for(size_t round = 0; round < 16; ++round)
+      for(size_t i = 0; i < SET_ARRAYS; ++i)
+        found += plain.count(queries[i]);
+    doNotOptimize(found);
+  });
+  runner.run("unordered_set<HashedArray> lookups", REPETITIONS, [&]()
+  {
+    size_t found = 0;
+    for(size_t round = 0; round < 16; ++round)
+      for(size_t i = 0; i < SET_ARRAYS; ++i)
+        found += hashed.count(hashedQueries[i]);
+    doNotOptimize(found);
+  });
+}
+
+void benchmarkHashMap(BenchmarkRunner& runner)
+{
+  const size_t KEYS = 1 << 20;
+
+  const Array<int> keys = randomArray<int>(KEYS, 9);
+  const Array<int> misses = randomArray<int>(KEYS, 10);
+
+  std::unordered_map<int, int> standard;
+  FlatHashMap<int, int> flat;
+
+  runner.run("std::unordered_map insert", REPETITIONS, [&]() { standard = std::unordered_map<int, int>(); }, [&]()
+  {
+    for(size_t i = 0; i < KEYS; ++i)
+      standard.insert(std::make_pair(keys[i], static_cast<int>(i)));
+  });
+  runner.run("FlatHashMap insert", REPETITIONS, [&]() { flat = FlatHashMap<int, int>(); }, [&]()
+  {
+    for(size_t i = 0; i < KEYS; ++i)
+      flat.insert(keys[i], static_cast<int>(i));
+  });
+
+  runner.run("std::unordered_map lookup hit", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < KEYS; ++i)
+      sum += standard.find(keys[i])->second;
+    doNotOptimize(sum);
+  });
+  runner.run("FlatHashMap lookup hit", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < KEYS; ++i)
+      sum += *flat.find(keys[i]);
+    doNotOptimize(sum);
+  });
+
+  runner.run("std::unordered_map lookup miss", REPETITIONS, [&]()
+  {
+    size_t found = 0;
+    for(size_t i = 0; i < KEYS; ++i)
+      found += standard.count(misses[i]);
+    doNotOptimize(found);
+  });
+  runner.run("FlatHashMap lookup miss", REPETITIONS, [&]()
+  {
+    size_t found = 0;
+    for(size_t i = 0; i < KEYS; ++i)
+      found += flat.contains(misses[i]);
+    doNotOptimize(found);
+  });
+}
+
+void benchmarkSlotMap(BenchmarkRunner& runner)
+{
+  const size_t COUNT = 1 << 20;
+
+  Array<size_t> order(COUNT);
+  for(size_t i = 0; i < COUNT; ++i)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(11));
+
+  SlotMap<int> slots;
+  Array<SlotHandle> handles(COUNT);
+  std::unordered_map<size_t, int> map;
+
+  runner.run("SlotMap insert", REPETITIONS, [&]() { slots = SlotMap<int>(); }, [&]()
+  {
+    for(size_t i = 0; i < COUNT; ++i)
+      handles[i] = slots.insert(static_cast<int>(i));
+  });
+  runner.run("std::unordered_map<id> insert", REPETITIONS, [&]() { map = std::unordered_map<size_t, int>(); }, [&]()
+  {
+    for(size_t i = 0; i < COUNT; ++i)
+      map.insert(std::make_pair(i, static_cast<int>(i)));
+  });
+
+  runner.run("SlotMap lookup", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < COUNT; ++i)
+      sum += *slots.find(handles[order[i]]);
+    doNotOptimize(sum);
+  });
+  runner.run("std::unordered_map<id> lookup", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t i = 0; i < COUNT; ++i)
+      sum += map.find(order[i])->second;
+    doNotOptimize(sum);
+  });
+
+  runner.run("SlotMap erase half", REPETITIONS, [&]()
+  {
+    slots = SlotMap<int>();
+    for(size_t i = 0; i < COUNT; ++i)
+      handles[i] = slots.insert(static_cast<int>(i));
+  }, [&]()
+  {
+    for(size_t i = 0; i < COUNT / 2; ++i)
+      slots.erase(handles[order[i]]);
+  });
+  runner.run("std::unordered_map<id> erase half", REPETITIONS, [&]()
+  {
+    map = std::unordered_map<size_t, int>();
+    for(size_t i = 0; i < COUNT; ++i)
+      map.insert(std::make_pair(i, static_cast<int>(i)));
+  }, [&]()
+  {
+    for(size_t i = 0; i < COUNT / 2; ++i)
+      map.erase(order[i]);
+  });
+
+  runner.run("SlotMap iterate", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(const int* value = slots.begin(); value != slots.end(); ++value)
+      sum += *value;
+    doNotOptimize(sum);
+  });
+  runner.run("std::unordered_map<id> iterate", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(std::unordered_map<size_t, int>::const_iterator it = map.begin(); it != map.end(); ++it)
+      sum += it->second;
+    doNotOptimize(sum);
+  });
+}
+
+// mutex-guarded queue, the baseline the ring buffer replaces
+template<typename T>
+class LockedQueue
+{
+public:
+  bool tryPush(const T& value)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.push(value);
+    return true;
+  }
+
+  bool tryPop(T& value)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_queue.empty())
+      return false;
+    value = m_queue.front();
+    m_queue.pop();
+    return true;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::queue<T> m_queue;
+};
+
+template<typename Queue>
+double transferSeconds(Queue& queue, const size_t count)
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+
+  std::thread consumer([&]()
+  {
+    size_t value = 0;
+    for(size_t received = 0; received < count; )
+      if(queue.tryPop(value))
+        ++received;
+      else
+        std::this_thread::yield();
+    doNotOptimize(value);
+  });
+
+  for(size_t sent = 0; sent < count; )
+    if(queue.tryPush(sent))
+      ++sent;
+    else
+      std::this_thread::yield();
+
+  consumer.join();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double batchedTransferSeconds(SpscRing<size_t>& ring, const size_t count, const size_t batch)
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+
+  std::thread consumer([&]()
+  {
+    Array<size_t> values(batch);
+    for(size_t received = 0; received < count; )
+    {
+      const size_t popped = ring.popBatch(values.data(), batch);
+      if(!popped)
+        std::this_thread::yield();
+      received += popped;
+    }
+    doNotOptimize(values.data());
+  });
+
+  Array<size_t> values(batch);
+  for(size_t sent = 0; sent < count; )
+  {
+    const size_t pushed = ring.pushBatch(values.data(), std::min(batch, count - sent));
+    if(!pushed)
+      std::this_thread::yield();
+    sent += pushed;
+  }
+
+  consumer.join();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string opsPerSecond(const size_t count, const double seconds)
+{
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1) << count / seconds / 1e6 << " Mops/s";
+  return text.str();
+}
+
+// one-way latency: the producer sends its clock reading, the consumer subtracts it from its own
+std::string ringLatencyPercentiles(const size_t count)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  SpscRing<Clock::rep> ring(1024);
+  Array<Clock::rep> latencies(count);
+
+  std::thread consumer([&]()
+  {
+    Clock::rep sent = 0;
+    for(size_t received = 0; received < count; )
+      if(ring.tryPop(sent))
+        latencies[received++] = Clock::now().time_since_epoch().count() - sent;
+      else
+        std::this_thread::yield();
+  });
+
+  for(size_t sent = 0; sent < count; )
+    if(ring.tryPush(Clock::now().time_since_epoch().count()))
+      ++sent;
+    else
+      std::this_thread::yield();
+
+  consumer.join();
+  std::sort(latencies.begin(), latencies.end());
+
+  const double toNs = 1e9 * Clock::period::num / Clock::period::den;
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(0)
+       << "p50 " << latencies[count / 2] * toNs << " ns"
+       << ", p99 " << latencies[count * 99 / 100] * toNs << " ns"
+       << ", p99.9 " << latencies[count * 999 / 1000] * toNs << " ns"
+       << ", max " << latencies[count - 1] * toNs << " ns";
+  return text.str();
+}
+
+void benchmarkRing(BenchmarkRunner& runner)
+{
+  const size_t COUNT = 1 << 22;
+
+  LockedQueue<size_t> locked;
+  runner.note("mutex + std::queue transfer", opsPerSecond(COUNT, transferSeconds(locked, COUNT)));
+
+  SpscRing<size_t> ring(4096);
+  runner.note("SpscRing transfer", opsPerSecond(COUNT, transferSeconds(ring, COUNT)));
+  runner.note("SpscRing batched transfer (64)", opsPerSecond(COUNT, batchedTransferSeconds(ring, COUNT, 64)));
+  runner.note("SpscRing latency", ringLatencyPercentiles(1 << 20));
+}
+
+void benchmarkJagged(BenchmarkRunner& runner)
+{
+  const size_t ROWS = 1 << 18;
+
+  std::mt19937 random(12);
+  Array<size_t> rowSizes(ROWS);
+  for(size_t row = 0; row < ROWS; ++row)
+    rowSizes[row] = random() % 16;
+
+  Array<Array<int> > nested;
+  JaggedArray<int> jagged;
+
+  runner.run("Array<Array<int>> build", REPETITIONS, [&]()
+  {
+    nested = Array<Array<int> >(ROWS);
+    for(size_t row = 0; row < ROWS; ++row)
+    {
+      nested[row] = Array<int>(rowSizes[row]);
+      for(size_t i = 0; i < rowSizes[row]; ++i)
+        nested[row][i] = static_cast<int>(row + i);
+    }
+  });
+  runner.run("JaggedArray<int> build", REPETITIONS, [&]()
+  {
+    jagged = JaggedArray<int>(rowSizes, [](const size_t row, ArrayView<int> values)
+    {
+      for(size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<int>(row + i);
+    });
+  });
+
+  runner.run("Array<Array<int>> copy", REPETITIONS, [&]()
+  {
+    const Array<Array<int> > copy = nested;
+    doNotOptimize(copy[ROWS - 1].data());
+  });
+  runner.run("JaggedArray<int> copy", REPETITIONS, [&]()
+  {
+    const JaggedArray<int> copy = jagged;
+    doNotOptimize(copy.values().data());
+  });
+
+  runner.run("Array<Array<int>> row sums", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t row = 0; row < ROWS; ++row)
+      for(const int* value = nested[row].data(); value != nested[row].data() + nested[row].size(); ++value)
+        sum += *value;
+    doNotOptimize(sum);
+  });
+  runner.run("JaggedArray<int> row sums", REPETITIONS, [&]()
+  {
+    size_t sum = 0;
+    for(size_t row = 0; row < ROWS; ++row)
+    {
+      const ArrayView<const int> values = static_cast<const JaggedArray<int>&>(jagged)[row];
+      for(const int* value = values.begin(); value != values.end(); ++value)
+        sum += *value;
+    }
+    doNotOptimize(sum);
+  });
+}
+
+void benchmarkMoveOnly(BenchmarkRunner& runner)
+{
+  const size_t SIZE = 1 << 20;
+
+  const Array<int> keys = randomArray<int>(SIZE, 13);
+  Array<std::unique_ptr<int> > unique;
+  Array<std::shared_ptr<int> > shared;
+
+  runner.run("Array<std::unique_ptr<int>> fill", REPETITIONS, [&]()
+  {
+    unique = Array<std::unique_ptr<int> >(SIZE);
+    for(size_t i = 0; i < SIZE; ++i)
+      unique[i].reset(new int(keys[i]));
+  });
+  runner.run("Array<std::shared_ptr<int>> fill", REPETITIONS, [&]()
+  {
+    shared = Array<std::shared_ptr<int> >(SIZE);
+    for(size_t i = 0; i < SIZE; ++i)
+      shared[i] = std::make_shared<int>(keys[i]);
+  });
+
+  runner.run("Array<std::unique_ptr<int>> sort by pointee", REPETITIONS, [&]()
+  {
+    std::sort(unique.begin(), unique.end(), [](const std::unique_ptr<int>& left, const std::unique_ptr<int>& right)
+    {
+      return *left < *right;
+    });
+    std::reverse(unique.begin(), unique.end());
+  });
+  runner.run("Array<std::shared_ptr<int>> sort by pointee", REPETITIONS, [&]()
+  {
+    std::sort(shared.begin(), shared.end(), [](const std::shared_ptr<int>& left, const std::shared_ptr<int>& right)
+    {
+      return *left < *right;
+    });
+    std::reverse(shared.begin(), shared.end());
+  });
+}
+
+template<typename BoundsCheck>
+void benchmarkBoundsCheck(BenchmarkRunner& runner, const std::string& policy, const Array<size_t>& indices)
+{
+  Array<int, BoundsCheck> values(indices.size());
+  for(size_t i = 0; i < values.size(); ++i)
+    values[i] = static_cast<int>(i);
+
+  runner.run("operator[] sequential, " + policy, REPETITIONS, [&]()
+  {
+    int sum = 0;
+    for(size_t i = 0; i < values.size(); ++i)
+      sum += values[i];
+    doNotOptimize(sum);
+  });
+  runner.run("operator[] random, " + policy, REPETITIONS, [&]()
+  {
+    int sum = 0;
+    for(size_t i = 0; i < indices.size(); ++i)
+      sum += values[indices[i]];
+    doNotOptimize(sum);
+  });
+
+  // pointers for the unchecked policies, CheckedIterators for the others
+  runner.run("iterator sequential, " + policy, REPETITIONS, [&]()
+  {
+    doNotOptimize(std::accumulate(values.begin(), values.end(), 0));
+  });
+}
+
+template<typename Storage>
+void benchmarkStorage(BenchmarkRunner& runner, const std::string& storage)
+{
+  const size_t SMALL_ARRAYS = 1 << 16;
+  const size_t SMALL_SIZE = 16;
+  const size_t LARGE_SIZE = 1 << 24;
+
+  Arena arena;
+  ArenaScope scope(arena);
+
+  runner.run("small Arrays create and destroy, " + storage, REPETITIONS, [&]() { arena.release(); }, [&]()
+  {
+    for(size_t i = 0; i < SMALL_ARRAYS; ++i)
+    {
+      Array<int, AssertBoundsCheck, Storage> values(SMALL_SIZE, Uninitialized());
+      doNotOptimize(values.data());
+    }
+  });
+  runner.run("large Array create, touch and destroy, " + storage, REPETITIONS, [&]() { arena.release(); }, [&]()
+  {
+    Array<int, AssertBoundsCheck, Storage> values(LARGE_SIZE);
+    doNotOptimize(values.data());
+  });
+}
+
+void benchmarkPolicies(BenchmarkRunner& runner)
+{
+  const size_t SIZE = 1 << 22;
+
+  Array<size_t> indices(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+    indices[i] = i;
+  std::shuffle(indices.begin(), indices.end(), std::mt19937(14));
+
+  benchmarkBoundsCheck<NoBoundsCheck>(runner, "no check", indices);
+  benchmarkBoundsCheck<AssertBoundsCheck>(runner, "assert", indices);
+  benchmarkBoundsCheck<ThrowBoundsCheck>(runner, "throw", indices);
+  benchmarkBoundsCheck<SampledBoundsCheck<64> >(runner, "sampled 1/64", indices);
+
+  benchmarkStorage<HeapStorage>(runner, "heap");
+  benchmarkStorage<ArenaStorage>(runner, "arena");
+  benchmarkStorage<MmapStorage>(runner, "mmap");
+}
+
+void benchmarkStreaming(BenchmarkRunner& runner)
+{
+  const size_t SIZE = (256 << 20) / sizeof(int);
+  const size_t WORKING_SET = (1 << 20) / sizeof(int);
+
+  const Array<int> source = randomArray<int>(SIZE, 15);
+  Array<int> destination(SIZE);
+  const Array<int> workingSet = randomArray<int>(WORKING_SET, 16);
+
+  const auto bandwidth = [&](const std::string& name)
+  {
+    const double ms = runner.results().back().minMs;
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << 2.0 * SIZE * sizeof(int) / (ms * 1e6) << " GB/s read+write";
+    runner.note(name, text.str());
+  };
+
+  runner.run("std::copy 256 MB", REPETITIONS, [&]() { std::copy(source.begin(), source.end(), destination.begin()); });
+  bandwidth("  bandwidth");
+  runner.run("streamingCopy 256 MB", REPETITIONS, [&]() { streamingCopy(source.data(), destination.data(), SIZE); });
+  bandwidth("  bandwidth");
+
+  runner.run("std::fill 256 MB", REPETITIONS, [&]() { std::fill(destination.begin(), destination.end(), 7); });
+  runner.run("streamingFill 256 MB", REPETITIONS, [&]() { streamingFill(destination.data(), SIZE, 7); });
+
+  // a cache-resident workload warmed up before the copy and timed right after it: the cached copy
+  // has evicted its working set, the streaming copy has not
+  const auto sumWorkingSet = [&]()
+  {
+    int sum = 0;
+    for(size_t i = 0; i < WORKING_SET; ++i)
+      sum += workingSet[i];
+    doNotOptimize(sum);
+  };
+
+  runner.run("1 MB working set after std::copy", REPETITIONS, [&]()
+  {
+    sumWorkingSet();
+    std::copy(source.begin(), source.end(), destination.begin());
+  }, sumWorkingSet);
+  runner.run("1 MB working set after streamingCopy", REPETITIONS, [&]()
+  {
+    sumWorkingSet();
+    streamingCopy(source.data(), destination.data(), SIZE);
+  }, sumWorkingSet);
+}
+
+void benchmarkPrefetchedCopy(BenchmarkRunner& runner)
+{
+  const size_t ROWS = 1 << 18;
+  const size_t ROW_SIZE = 24;
+
+  // rows allocated in random order so that consecutive rows live far apart on the heap
+  Array<size_t> order(ROWS);
+  for(size_t row = 0; row < ROWS; ++row)
+    order[row] = row;
+  std::shuffle(order.begin(), order.end(), std::mt19937(17));
+
+  Array<Array<int> > nested(ROWS);
+  for(size_t i = 0; i < ROWS; ++i)
+    nested[order[i]] = Array<int>(ROW_SIZE);
+
+  Array<std::string> strings(ROWS);
+  for(size_t i = 0; i < ROWS; ++i)
+    strings[order[i]] = std::string(40, static_cast<char>('a' + i % 26));
+
+  runner.run("Array<Array<int>> copy constructor", REPETITIONS, [&]()
+  {
+    const Array<Array<int> > copy = nested;
+    doNotOptimize(copy.data());
+  });
+
+  const size_t distances[] = { 2, 4, 8, 16, 32 };
+  for(size_t distance : distances)
+    runner.run("Array<Array<int>> prefetchedCopy, distance " + std::to_string(distance), REPETITIONS, [&]()
+    {
+      const Array<Array<int> > copy = prefetchedCopy(nested, distance);
+      doNotOptimize(copy.data());
+    });
+
+  runner.run("Array<std::string> copy constructor", REPETITIONS, [&]()
+  {
+    const Array<std::string> copy = strings;
+    doNotOptimize(copy.data());
+  });
+  runner.run("Array<std::string> prefetchedCopy", REPETITIONS, [&]()
+  {
+    const Array<std::string> copy = prefetchedCopy(strings);
+    doNotOptimize(copy.data());
+  });
+}
+
+void benchmarkNuma(BenchmarkRunner& runner)
+{
+  const size_t SIZE = (512 << 20) / sizeof(double);
+  const size_t threads = parallelThreadCount(SIZE, NUMA_TOUCH_GRAIN);
+
+  runner.note("memory nodes", std::to_string(numaNodeCount()) + ", " + std::to_string(threads) + " threads");
+
+  const auto parallelSum = [&](const Array<double>& values)
+  {
+    parallelFor(values.size(), threads, [&](const size_t, const size_t begin, const size_t end)
+    {
+      double sum = 0;
+      for(size_t i = begin; i < end; ++i)
+        sum += values[i];
+      doNotOptimize(sum);
+    });
+  };
+
+  Array<double> serial;
+  Array<double> firstTouch;
+  Array<double> interleaved;
+
+  runner.run("Array<double>(n), one thread touches", REPETITIONS, [&]() { serial = Array<double>(); },
+             [&]() { serial = Array<double>(SIZE); });
+  runner.run("numaArray<double>(n), first touch", REPETITIONS, [&]() { firstTouch = Array<double>(); },
+             [&]() { firstTouch = numaArray<double>(SIZE); });
+  runner.run("numaArray<double>(n), interleave", REPETITIONS, [&]() { interleaved = Array<double>(); },
+             [&]() { interleaved = numaArray<double>(SIZE, NumaPlacement::Interleave); });
+
+  runner.run("parallel sum, single-thread initialized", REPETITIONS, [&]() { parallelSum(serial); });
+  runner.run("parallel sum, first touch", REPETITIONS, [&]() { parallelSum(firstTouch); });
+  runner.run("parallel sum, interleaved", REPETITIONS, [&]() { parallelSum(interleaved); });
+}
+
+void benchmarkIncrementalCopy(BenchmarkRunner& runner)
+{
+  const size_t SIZE = (64 << 20) / sizeof(int);
+
+  const Array<int> source = randomArray<int>(SIZE, 18);
+  Array<int> target;
+
+  runner.run("Array<int> copy, 64 MB in one go", REPETITIONS, [&]() { target = source; });
+
+  const size_t slices[] = { 1 << 14, 1 << 16, 1 << 18 };
+  for(size_t slice : slices)
+  {
+    typedef std::chrono::steady_clock Clock;
+    double longestStepMs = 0;
+
+    runner.run("IncrementalCopy, slice " + std::to_string(slice), REPETITIONS, [&]()
+    {
+      IncrementalCopy<int> copy(target, source, slice);
+      for(;;)
+      {
+        const Clock::time_point start = Clock::now();
+        const bool committed = copy.step();
+        longestStepMs = std::max(longestStepMs, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        if(committed)
+          break;
+      }
+    });
+
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3) << longestStepMs << " ms";
+    runner.note("  longest step", text.str());
+  }
+}
+
+void benchmarkOperationLatency(BenchmarkRunner& runner)
+{
+  const size_t sizes[] = { 1 << 10, 1 << 16, 1 << 20 };
+  for(size_t size : sizes)
+  {
+    const size_t operations = size >= (1 << 20) ? 200 : 2000;
+    const std::string suffix = ", " + std::to_string(size * sizeof(int) / 1024) + " KB";
+
+    const Array<int> source(size);
+    Array<int> target;
+    std::unique_ptr<Array<int> > doomed;
+
+    runner.runLatency("construct" + suffix, operations, [&]() { target = Array<int>(); },
+                      [&]() { target = Array<int>(size); });
+    runner.runLatency("copy" + suffix, operations, [&]() { target = Array<int>(); }, [&]()
+    {
+      Array<int> copy(source);
+      target.swap(target, copy);
+    });
+    runner.runLatency("assign" + suffix, operations, [&]() { target = Array<int>(size / 2); },
+                      [&]() { target = source; });
+    runner.runLatency("destroy" + suffix, operations, [&]() { doomed.reset(new Array<int>(source)); },
+                      [&]() { doomed.reset(); });
+  }
+}
+
+void benchmarkTracing(BenchmarkRunner& runner)
+{
+  // two events per Array, all of them fit in the ring so no run measures the drop path
+  const size_t ARRAYS = detail::TraceRing::CAPACITY / 2;
+  const size_t sizes[] = { 16, 1024 };
+
+  for(size_t size : sizes)
+  {
+    const std::string suffix = " x " + std::to_string(ARRAYS) + ", " + std::to_string(size) + " ints";
+
+    runner.run("Array<int> create + destroy" + suffix, REPETITIONS, [&]()
+    {
+      for(size_t i = 0; i < ARRAYS; ++i)
+        Array<int>(size, Uninitialized());
+    });
+
+    // what the ARRAY_TRACE hooks add to the same loop
+    runner.run("  with tracing" + suffix, REPETITIONS, [&]()
+    {
+      ArrayTracer::clear();
+      for(size_t i = 0; i < ARRAYS; ++i)
+      {
+        Array<int> array(size, Uninitialized());
+        ArrayTracer::record<int>(TraceOp::Create, array.size());
+        ArrayTracer::record<int>(TraceOp::Destroy, array.size());
+      }
+    });
+  }
+
+  std::ostringstream trace;
+  runner.run("Chrome trace dump, " + std::to_string(ARRAYS * 2) + " events", REPETITIONS, [&]()
+  {
+    ArrayTracer::clear();
+    for(size_t i = 0; i < ARRAYS * 2; ++i)
+      ArrayTracer::record<int>(TraceOp::Create, i);
+
+    trace.str("");
+    ArrayTracer::dumpChromeTrace(trace);
+  });
+}
+
+void benchmarkAllocationProfiler(BenchmarkRunner& runner)
+{
+  const size_t ARRAYS = 1 << 16;
+  const size_t sizes[] = { 16, 1024 };
+  const size_t intervals[] = { 0, ALLOCATION_SAMPLE_INTERVAL, 4 << 10 };
+
+  for(size_t size : sizes)
+    for(size_t interval : intervals)
+    {
+      std::string name = "Array<int> create + destroy x " + std::to_string(ARRAYS) + ", " + std::to_string(size) + " ints";
+      if(interval)
+        name = "  sampling every " + std::to_string(interval >> 10) + " KB";
+
+      if(interval)
+        AllocationProfiler::start(interval);
+      runner.run(name, REPETITIONS, [&]()
+      {
+        for(size_t i = 0; i < ARRAYS; ++i)
+          Array<int>(size, Uninitialized());
+      });
+      AllocationProfiler::stop();
+    }
+
+  // the heaviest sites of the last run, innermost frame only
+  const std::vector<AllocationProfiler::Site> sites = AllocationProfiler::sites();
+  for(size_t s = 0; s < sites.size() && s < 3; ++s)
+  {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << sites[s].bytes / (1 << 20) << " MB estimated, "
+         << sites[s].samples << " samples";
+    runner.note("  site " + (sites[s].frames.empty() ? std::string("[unknown]") : sites[s].frames.back()), text.str());
+  }
+}
+
+template<typename T>
+void benchmarkCompressedData(BenchmarkRunner& runner, const std::string& label, const Array<T>& values)
+{
+  CompressedArray<T> compressed;
+  runner.run("compress " + label, REPETITIONS, [&]() { compressed = CompressedArray<T>(values); });
+
+  std::ostringstream ratio;
+  ratio << std::fixed << std::setprecision(2) << double(values.size() * sizeof(T)) / compressed.compressedBytes()
+        << " : 1 (" << compressed.compressedBytes() / 1024 << " KB)";
+  runner.note("  ratio", ratio.str());
+
+  Array<T> restored;
+  runner.run("  decompress all", REPETITIONS, [&]() { restored = compressed.decompress(); });
+
+  T sum = T();
+  runner.run("  sequential scan, operator[]", REPETITIONS, [&]()
+  {
+    for(size_t i = 0; i < compressed.size(); ++i)
+      sum += compressed[i];
+  });
+  runner.run("  sequential scan, uncompressed Array", REPETITIONS, [&]()
+  {
+    for(size_t i = 0; i < values.size(); ++i)
+      sum += values[i];
+  });
+
+  // random reads miss the cache almost always: each one decompresses a 64 KB block
+  std::mt19937_64 random(19);
+  runner.runLatency("  random read", 2000, [&]() { sum += compressed[random() % compressed.size()]; });
+  runner.runLatency("  cached read", 2000, [&]() { sum += compressed[random() % CompressedArray<T>::BLOCK_ELEMENTS]; });
+  doNotOptimize(sum);
+}
+
+void benchmarkCompressed(BenchmarkRunner& runner)
+{
+  const size_t SIZE = (64 << 20) / sizeof(int);
+  std::mt19937 random(20);
+
+  Array<int> counts(SIZE, Uninitialized());
+  Array<int> sparse(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    counts[i] = static_cast<int>(random() % 1000);
+    if(random() % 64 == 0)
+      sparse[i] = static_cast<int>(random());
+  }
+
+  benchmarkCompressedData(runner, "64 MB of ints below 1000", counts);
+  benchmarkCompressedData(runner, "64 MB of ints, 1 in 64 non-zero", sparse);
+  benchmarkCompressedData(runner, "64 MB of random ints", randomArray<int>(SIZE, 21));
+}
+
+void benchmarkFrozen(BenchmarkRunner& runner)
+{
+  const size_t SIZE = (16 << 20) / sizeof(int);
+  const size_t READERS = 8;
+
+  const Array<int> source = randomArray<int>(SIZE, 22);
+
+  // every reader thread gets its own copy, or a reference to the same frozen elements
+  runner.run("8 readers, defensive Array<int> copies, 16 MB", REPETITIONS, [&]()
+  {
+    std::vector<std::thread> readers;
+    for(size_t r = 0; r < READERS; ++r)
+    {
+      Array<int> copy(source);
+      readers.push_back(std::thread([](const Array<int>& values)
+      {
+        doNotOptimize(std::accumulate(values.begin(), values.end(), 0LL));
+      }, std::move(copy)));
+    }
+    for(size_t r = 0; r < READERS; ++r)
+      readers[r].join();
+  });
+
+  FrozenArray<int> frozen;
+  runner.run("freeze a copy, 16 MB (copy + hash)", REPETITIONS, [&]() { frozen = freeze(Array<int>(source)); });
+
+  runner.run("8 readers, shared FrozenArray<int>, 16 MB", REPETITIONS, [&]()
+  {
+    std::vector<std::thread> readers;
+    for(size_t r = 0; r < READERS; ++r)
+      readers.push_back(std::thread([frozen]()
+      {
+        doNotOptimize(std::accumulate(frozen.begin(), frozen.end(), 0LL));
+      }));
+    for(size_t r = 0; r < READERS; ++r)
+      readers[r].join();
+  });
+
+  const FrozenArray<int> other = freeze(frozen.thaw());
+  runner.run("FrozenArray<int> equality, 16 MB, hashes equal", REPETITIONS, [&]() { doNotOptimize(frozen == other); });
+}
+
+
+// one operation on each of 'sources' and 'destinations' in turn, OPERATIONS times
+template<typename Operation>
+void benchmarkSmallOperation(BenchmarkRunner& runner, const std::string& name, const Array<Array<int> >& sources,
+                             Array<Array<int> >& destinations, Operation operation)
+{
+  const size_t OPERATIONS = 1 << 20;
+
+  runner.run(name, REPETITIONS, [&]()
+  {
+    for(size_t i = 0; i < OPERATIONS; ++i)
+      operation(sources[i % sources.size()], destinations[i % sources.size()]);
+  });
+
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(2) << runner.results().back().minMs * 1e6 / OPERATIONS << " ns per Array";
+  runner.note("  latency", text.str());
+}
+
+// fill of 1-64 element Arrays, the sizes are random so that the size class branch is not
+// predictable; and a copy of a size known at compile time
+void benchmarkSmallKernels(BenchmarkRunner& runner)
+{
+  const size_t ARRAYS = 4096;
+
+  std::mt19937 random(23);
+  Array<Array<int> > sources(ARRAYS);
+  Array<Array<int> > destinations(ARRAYS);
+  Array<Array<int> > fixed(ARRAYS);
+  Array<Array<int> > fixedDestinations(ARRAYS);
+  for(size_t a = 0; a < ARRAYS; ++a)
+  {
+    sources[a] = randomArray<int>(1 + random() % SMALL_KERNEL_LIMIT, 24 + a);
+    destinations[a] = Array<int>(sources[a].size());
+    fixed[a] = randomArray<int>(16, 24 + a);
+    fixedDestinations[a] = Array<int>(16);
+  }
+
+  benchmarkSmallOperation(runner, "std::fill, 1-64 ints", sources, destinations,
+                          [](const Array<int>& source, Array<int>& destination)
+  {
+    std::fill(destination.begin(), destination.end(), source[0]);
+    doNotOptimize(destination[0]);
+  });
+  benchmarkSmallOperation(runner, "smallFill, 1-64 ints", sources, destinations,
+                          [](const Array<int>& source, Array<int>& destination)
+  {
+    smallFill(destination.data(), destination.size(), source[0]);
+    doNotOptimize(destination[0]);
+  });
+
+  // a size known at compile time needs no dispatch at all
+  benchmarkSmallOperation(runner, "std::copy, 16 ints", fixed, fixedDestinations,
+                          [](const Array<int>& source, Array<int>& destination)
+  {
+    std::copy(source.begin(), source.begin() + 16, destination.begin());
+    doNotOptimize(destination[0]);
+  });
+  benchmarkSmallOperation(runner, "copyFixed<16>, 16 ints", fixed, fixedDestinations,
+                          [](const Array<int>& source, Array<int>& destination)
+  {
+    copyFixed<16>(source.data(), destination.data());
+    doNotOptimize(destination[0]);
+  });
+}
+
+// the Foo of the tests without its counters: a constructor that does work and a class
+// operator new[] that goes to the global heap
+struct HeapFoo
+{
+  HeapFoo(int data = 5)
+    : m_data(data)
+  {
+  }
+
+  void* operator new[](const size_t bytes)
+  {
+    return ::operator new[](bytes);
+  }
+
+  void operator delete[](void* memory) noexcept
+  {
+    ::operator delete[](memory);
+  }
+
+  int m_data;
+};
+
+struct PooledFoo : PoolAllocated<PooledFoo>
+{
+  PooledFoo(int data = 5)
+    : m_data(data)
+  {
+  }
+
+  int m_data;
+};
+
+// ARRAYS Arrays of random sizes up to 'maxSize' built and destroyed, interleaved so that a
+// few of them are alive at a time, on every one of 'threads' threads
+template<typename Element>
+void benchmarkPooledArrays(BenchmarkRunner& runner, const std::string& name, const size_t maxSize, const size_t threads)
+{
+  const size_t ARRAYS = 1 << 16;
+  const size_t LIVE = 8;
+
+  std::mt19937 random(25);
+  std::vector<size_t> sizes(ARRAYS);
+  for(size_t i = 0; i < ARRAYS; ++i)
+    sizes[i] = 1 + random() % maxSize;
+
+  const auto build = [&]()
+  {
+    std::vector<Array<Element> > live(LIVE);
+    for(size_t i = 0; i < ARRAYS; ++i)
+    {
+      live[i % LIVE] = Array<Element>(sizes[i]);
+      doNotOptimize(live[i % LIVE].data());
+    }
+  };
+
+  runner.run(name, REPETITIONS, [&]()
+  {
+    if(threads == 1)
+    {
+      build();
+      return;
+    }
+
+    std::vector<std::thread> builders;
+    for(size_t t = 0; t < threads; ++t)
+      builders.push_back(std::thread(build));
+    for(size_t t = 0; t < threads; ++t)
+      builders[t].join();
+  });
+}
+
+void benchmarkObjectPool(BenchmarkRunner& runner)
+{
+  benchmarkPooledArrays<HeapFoo>(runner, "64K Array<Foo> of 1-16, global heap", 16, 1);
+  benchmarkPooledArrays<PooledFoo>(runner, "64K Array<Foo> of 1-16, pool", 16, 1);
+  benchmarkPooledArrays<HeapFoo>(runner, "64K Array<Foo> of 1-1000, global heap", 1000, 1);
+  benchmarkPooledArrays<PooledFoo>(runner, "64K Array<Foo> of 1-1000, pool", 1000, 1);
+  benchmarkPooledArrays<HeapFoo>(runner, "4 threads, 64K Array<Foo> of 1-16, heap", 16, 4);
+  benchmarkPooledArrays<PooledFoo>(runner, "4 threads, 64K Array<Foo> of 1-16, pool", 16, 4);
+}
+
+} // namespace
+
+// --counters (or BENCHMARK_COUNTERS in the environment) adds hardware counters to every case
+int main(int argc, char* argv[])
+{
+  BenchmarkRunner runner;
+  std::string outputPath = "bench_output.txt";
+  std::string baselinePath;
+  double threshold = REGRESSION_THRESHOLD_PERCENT;
+
+  if(std::getenv("BENCHMARK_COUNTERS"))
+    runner.enableCounters();
+
+  for(int a = 1; a < argc; ++a)
+  {
+    const std::string option = argv[a];
+    const bool hasValue = a + 1 < argc;
+
+    if(option == "--counters")
+      runner.enableCounters();
+    else if(option == "--output" && hasValue)
+      outputPath = argv[++a];
+    else if(option == "--baseline" && hasValue)
+      baselinePath = argv[++a];
+    else if(option == "--threshold" && hasValue)
+      threshold = std::atof(argv[++a]);
+    else
+    {
+      std::cerr << "usage: " << argv[0]
+                << " [--counters] [--output file] [--baseline file] [--threshold percent]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // read the baseline first, a typo in its path should not cost a whole run
+  std::vector<BenchmarkResult> baseline;
+  if(!baselinePath.empty())
+  {
+    std::ifstream in(baselinePath.c_str());
+    if(!readResults(in, baseline))
+    {
+      std::cerr << "cannot read benchmark results from " << baselinePath << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  runner.section("sort and search");
+  benchmarkSort<int>(runner, "int");
+  benchmarkSort<double>(runner, "double");
+  benchmarkStableSort(runner);
+  benchmarkSearch<int>(runner, "int");
+  benchmarkSearch<double>(runner, "double");
+
+  runner.section("merge and set operations");
+  benchmarkMerge(runner);
+
+  runner.section("gather, scatter and permutations");
+  benchmarkPermute<int>(runner, "int");
+  benchmarkPermute<double>(runner, "double");
+
+  runner.section("histograms");
+  benchmarkHistograms(runner);
+
+  runner.section("hashing and equality");
+  benchmarkHash(runner);
+
+  runner.section("hash map");
+  benchmarkHashMap(runner);
+
+  runner.section("slot map");
+  benchmarkSlotMap(runner);
+
+  runner.section("spsc ring buffer");
+  benchmarkRing(runner);
+
+  runner.section("jagged array");
+  benchmarkJagged(runner);
+
+  runner.section("move-only elements");
+  benchmarkMoveOnly(runner);
+
+  runner.section("array policies");
+  benchmarkPolicies(runner);
+
+  runner.section("streaming copy and fill");
+  benchmarkStreaming(runner);
+
+  runner.section("prefetched element copy");
+  benchmarkPrefetchedCopy(runner);
+
+  runner.section("numa placement");
+  benchmarkNuma(runner);
+
+  runner.section("incremental copy");
+  benchmarkIncrementalCopy(runner);
+
+  runner.section("per-operation latency");
+  benchmarkOperationLatency(runner);
+
+  runner.section("lifecycle tracing");
+  benchmarkTracing(runner);
+
+  runner.section("allocation profiler");
+  benchmarkAllocationProfiler(runner);
+
+  runner.section("compressed array");
+  benchmarkCompressed(runner);
+
+  runner.section("frozen array");
+  benchmarkFrozen(runner);
+
+  runner.section("small kernels");
+  benchmarkSmallKernels(runner);
+
+  runner.section("object pool");
+  benchmarkObjectPool(runner);
+
+  std::ofstream out(outputPath.c_str());
+  writeResults(out, runner.results());
+  if(!out)
+    std::cerr << "cannot write benchmark results to " << outputPath << std::endl;
+
+  if(baselinePath.empty())
+    return EXIT_SUCCESS;
+
+  std::cout << "\n== regressions against " << baselinePath << " ==" << std::endl;
+  const size_t regressions = reportRegressions(std::cout, baseline, runner.results(), threshold);
+  if(!regressions)
+    std::cout << "none" << std::endl;
+
+  return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef> // size_t
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// keeps the optimizer from dropping a computed value
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+struct BenchmarkResult
+{
+  std::string name;
+  size_t repetitions;
+  double minMs;
+  double medianMs;
+  // every timed repetition in ascending order, for the baseline comparison
+  std::vector<double> samplesMs;
+  // hardware counter averages per repetition, empty unless counters are enabled
+  std::vector<std::pair<std::string, double> > counters;
+  // per-operation latency percentiles in microseconds, from runLatency
+  std::vector<std::pair<std::string, double> > percentiles;
+};
+
+class BenchmarkRunner
+{
+public:
+  explicit BenchmarkRunner(std::ostream& out = std::cout)
+    : m_out(out)
+  {
+  }
+
+  // also reads the hardware counters around every timed repetition; reports and returns false
+  // when the system does not allow it, the runner then keeps timing only
+  bool enableCounters()
+  {
+    m_counters.reset(new PerfCounters());
+    if(m_counters->available())
+    {
+      if(!m_counters->error().empty())
+        note("hardware counters", "partly unavailable, " + m_counters->error());
+      return true;
+    }
+
+    note("hardware counters", "unavailable, " + m_counters->error());
+    m_counters.reset();
+    return false;
+  }
+
+  // times 'body' after an untimed 'setup' on every repetition, plus one warm-up round
+  template<typename Setup, typename Body>
+  void run(const std::string& name, const size_t repetitions, Setup setup, Body body)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<double> times;
+    times.reserve(repetitions);
+    // summed by name, since a counter whose read fails is missing from that repetition, and
+    // averaged over the repetitions that read it
+    std::vector<std::pair<std::string, double> > counters;
+    std::vector<size_t> reads;
+
+    for(size_t i = 0; i <= repetitions; ++i)
+    {
+      setup();
+      // not around the warm-up round, whose counts are thrown away with its time
+      if(m_counters && i)
+        m_counters->start();
+      const Clock::time_point start = Clock::now();
+      body();
+      const Clock::time_point stop = Clock::now();
+
+      if(!i)
+        continue;
+
+      times.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+
+      if(m_counters)
+      {
+        const std::vector<std::pair<std::string, uint64_t> > counts = m_counters->stop();
+        for(size_t c = 0; c < counts.size(); ++c)
+        {
+          size_t k = 0;
+          while(k < counters.size() && counters[k].first != counts[c].first)
+            ++k;
+          if(k == counters.size())
+          {
+            counters.push_back(std::make_pair(counts[c].first, 0.0));
+            reads.push_back(0);
+          }
+
+          counters[k].second += static_cast<double>(counts[c].second);
+          ++reads[k];
+        }
+      }
+    }
+
+    for(size_t k = 0; k < counters.size(); ++k)
+      counters[k].second /= reads[k];
+
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.repetitions = repetitions;
+    result.minMs = times.empty() ? 0 : times.front();
+    result.medianMs = times.empty() ? 0 : times[times.size() / 2];
+    result.samplesMs = times;
+    result.counters = counters;
+    m_results.push_back(result);
+
+    m_out << std::left << std::setw(48) << name
+          << std::right << std::fixed << std::setprecision(3)
+          << " min " << std::setw(10) << result.minMs << " ms"
+          << " median " << std::setw(10) << result.medianMs << " ms" << std::endl;
+
+    if(!counters.empty())
+    {
+      m_out << std::setw(48) << "";
+      for(size_t c = 0; c < counters.size(); ++c)
+        m_out << " " << counters[c].first << " " << std::setprecision(0) << counters[c].second;
+      m_out << std::endl;
+    }
+  }
+
+  template<typename Body>
+  void run(const std::string& name, const size_t repetitions, Body body)
+  {
+    run(name, repetitions, []() {}, body);
+  }
+
+  // times every single call of 'operation' after an untimed 'setup' and reports the latency
+  // distribution instead of a run time: the allocation and page-fault tail shows in p99 and up
+  template<typename Setup, typename Operation>
+  void runLatency(const std::string& name, const size_t operations, Setup setup, Operation operation)
+  {
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyHistogram histogram;
+    for(size_t i = 0; i < operations; ++i)
+    {
+      setup();
+      const Clock::time_point start = Clock::now();
+      operation();
+      const Clock::time_point stop = Clock::now();
+      histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()));
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.repetitions = operations;
+    result.minMs = histogram.percentile(0) / 1e6;
+    result.medianMs = histogram.percentile(50) / 1e6;
+
+    const double PERCENTS[] = { 50, 99, 99.9 };
+    const char* LABELS[] = { "p50", "p99", "p99.9" };
+    for(size_t p = 0; p < 3; ++p)
+      result.percentiles.push_back(std::make_pair(std::string(LABELS[p]), histogram.percentile(PERCENTS[p]) / 1e3));
+    result.percentiles.push_back(std::make_pair(std::string("max"), histogram.max() / 1e3));
+    m_results.push_back(result);
+
+    m_out << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(2);
+    for(size_t p = 0; p < result.percentiles.size(); ++p)
+      m_out << " " << result.percentiles[p].first << " " << std::setw(9) << result.percentiles[p].second << " us";
+    m_out << std::endl;
+  }
+
+  template<typename Operation>
+  void runLatency(const std::string& name, const size_t operations, Operation operation)
+  {
+    runLatency(name, operations, []() {}, operation);
+  }
+
+  // free-form result line for numbers that are not a run time, e.g. throughput or percentiles
+  void note(const std::string& name, const std::string& text)
+  {
+    m_out << std::left << std::setw(48) << name << " " << text << std::endl;
+  }
+
+  void section(const std::string& title)
+  {
+    m_out << std::endl << "== " << title << " ==" << std::endl;
+  }
+
+  const std::vector<BenchmarkResult>& results() const
+  {
+    return m_results;
+  }
+
+private:
+  std::ostream& m_out;
+  std::vector<BenchmarkResult> m_results;
+  std::unique_ptr<PerfCounters> m_counters;
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "benchmark.h"
+
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// results file: a header line, then one tab-separated line per timed case
+//   name <TAB> repetitions <TAB> min ms <TAB> median ms <TAB> space-separated samples in ms
+// latency cases (runLatency) have no samples and are written with their percentiles only
+const char* const BENCHMARK_RESULTS_HEADER = "# exception-safety-construction benchmark results v1";
+
+// default regression gate: slower by more than this many percent at the median...
+const double REGRESSION_THRESHOLD_PERCENT = 10;
+// ...and the samples are slower with this significance (one-sided Mann-Whitney U)
+const double REGRESSION_SIGNIFICANCE = 0.05;
+// sample count products up to which the U test is computed exactly
+const size_t EXACT_U_TEST_LIMIT = 400;
+
+inline void writeResults(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+  out << BENCHMARK_RESULTS_HEADER << "\n" << std::setprecision(6);
+
+  for(size_t r = 0; r < results.size(); ++r)
+  {
+    const BenchmarkResult& result = results[r];
+    out << result.name << "\t" << result.repetitions << "\t" << result.minMs << "\t" << result.medianMs << "\t";
+
+    for(size_t s = 0; s < result.samplesMs.size(); ++s)
+      out << (s ? " " : "") << result.samplesMs[s];
+
+    for(size_t p = 0; p < result.percentiles.size(); ++p)
+      out << (p ? " " : "") << result.percentiles[p].first << "=" << result.percentiles[p].second << "us";
+
+    out << "\n";
+  }
+}
+
+// reads what writeResults wrote; false on a missing header or a malformed line
+inline bool readResults(std::istream& in, std::vector<BenchmarkResult>& results)
+{
+  std::string line;
+  if(!std::getline(in, line) || line != BENCHMARK_RESULTS_HEADER)
+    return false;
+
+  results.clear();
+  while(std::getline(in, line))
+  {
+    if(line.empty())
+      continue;
+
+    std::istringstream fields(line);
+    BenchmarkResult result;
+    std::string repetitions, minMs, medianMs, samples;
+
+    if(!std::getline(fields, result.name, '\t') || !std::getline(fields, repetitions, '\t')
+       || !std::getline(fields, minMs, '\t') || !std::getline(fields, medianMs, '\t'))
+      return false;
+    std::getline(fields, samples);
+
+    std::istringstream numbers(repetitions + " " + minMs + " " + medianMs);
+    if(!(numbers >> result.repetitions >> result.minMs >> result.medianMs))
+      return false;
+
+    // percentile entries of latency cases are not numbers and end the sample list
+    std::istringstream values(samples);
+    double sample = 0;
+    while(values >> sample)
+      result.samplesMs.push_back(sample);
+
+    results.push_back(result);
+  }
+
+  return true;
+}
+
+// probability that the 'current' samples come out at least this much slower than the
+// 'baseline' samples if both had the same distribution: one-sided Mann-Whitney U test, exact
+// for the handful of repetitions a benchmark run has, ties counted as half
+inline double slowdownPValue(const std::vector<double>& baseline, const std::vector<double>& current)
+{
+  const size_t m = current.size();
+  const size_t n = baseline.size();
+  if(!m || !n)
+    return 1;
+
+  // U counts the (current, baseline) pairs where the current sample is slower, doubled so that
+  // ties stay integral
+  size_t doubledU = 0;
+  for(size_t i = 0; i < m; ++i)
+    for(size_t j = 0; j < n; ++j)
+      doubledU += current[i] > baseline[j] ? 2 : current[i] == baseline[j] ? 1 : 0;
+
+  // large samples: normal approximation with continuity correction
+  if(m * n > EXACT_U_TEST_LIMIT)
+  {
+    const double mean = m * n / 2.0;
+    const double deviation = std::sqrt(m * n * (m + n + 1) / 12.0);
+    const double z = (doubledU / 2.0 - 0.5 - mean) / deviation;
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+  }
+
+  // f[k][l][u]: orderings of k current and l baseline samples with statistic u. The largest
+  // sample is either a current one, slower than all l baseline samples, or a baseline one:
+  // f(k, l, u) = f(k - 1, l, u - l) + f(k, l - 1, u)
+  std::vector<std::vector<std::vector<double> > > f(m + 1,
+    std::vector<std::vector<double> >(n + 1, std::vector<double>(m * n + 1, 0)));
+  for(size_t k = 0; k <= m; ++k)
+    for(size_t l = 0; l <= n; ++l)
+      for(size_t u = 0; u <= k * l; ++u)
+      {
+        if(!k || !l)
+        {
+          f[k][l][u] = u ? 0 : 1;
+          continue;
+        }
+
+        f[k][l][u] = (u >= l ? f[k - 1][l][u - l] : 0) + f[k][l - 1][u];
+      }
+
+  double total = 0;
+  double atLeast = 0;
+  for(size_t u = 0; u <= m * n; ++u)
+  {
+    total += f[m][n][u];
+    if(2 * u >= doubledU)
+      atLeast += f[m][n][u];
+  }
+
+  return atLeast / total;
+}
+
+// compares every case of 'current' with the case of the same name in 'baseline' and reports
+// each one that got slower by more than 'thresholdPercent' at the median with a significant
+// slowdown of the samples; returns how many regressed
+inline size_t reportRegressions(std::ostream& out, const std::vector<BenchmarkResult>& baseline,
+                                const std::vector<BenchmarkResult>& current,
+                                const double thresholdPercent = REGRESSION_THRESHOLD_PERCENT)
+{
+  size_t regressions = 0;
+
+  for(size_t c = 0; c < current.size(); ++c)
+  {
+    const BenchmarkResult& now = current[c];
+    if(now.samplesMs.empty())
+      continue;
+
+    const BenchmarkResult* before = nullptr;
+    for(size_t b = 0; b < baseline.size() && !before; ++b)
+      if(baseline[b].name == now.name)
+        before = &baseline[b];
+
+    if(!before || before->samplesMs.empty() || before->medianMs <= 0)
+      continue;
+
+    const double change = (now.medianMs / before->medianMs - 1) * 100;
+    const double pValue = slowdownPValue(before->samplesMs, now.samplesMs);
+
+    if(change > thresholdPercent && pValue < REGRESSION_SIGNIFICANCE)
+    {
+      ++regressions;
+      out << std::left << std::setw(48) << now.name << std::right << std::fixed << std::setprecision(1)
+          << " REGRESSION +" << change << "% (median " << std::setprecision(3) << before->medianMs << " -> "
+          << now.medianMs << " ms, p = " << pValue << ")" << std::endl;
+    }
+  }
+
+  return regressions;
+}
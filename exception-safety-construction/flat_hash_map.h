@@ -0,0 +1,467 @@
+#pragma once
+
+#include "array.h"
+#include "array_intrinsics.h" // detail::hashMix, detail::lowestBit
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring> // std::memset
+#include <functional> // std::hash, std::equal_to
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace detail
+{
+
+// control byte of every slot: empty, deleted, or the low 7 bits of the key hash for a full slot
+const signed char SLOT_EMPTY = -128;
+const signed char SLOT_DELETED = -2;
+const size_t GROUP_SIZE = 16;
+
+// bit i is set when control byte i of the 16-byte group equals 'value'
+inline unsigned groupMatch(const signed char* group, const signed char value)
+{
+#if defined(__SSE2__)
+  const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+  unsigned mask = 0;
+  for(size_t i = 0; i < GROUP_SIZE; ++i)
+    mask |= unsigned(group[i] == value) << i;
+  return mask;
+#endif
+}
+
+// bit i is set when slot i of the group is empty or deleted (full slots are non-negative)
+inline unsigned groupMatchFree(const signed char* group)
+{
+#if defined(__SSE2__)
+  const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return static_cast<unsigned>(_mm_movemask_epi8(control));
+#else
+  unsigned mask = 0;
+  for(size_t i = 0; i < GROUP_SIZE; ++i)
+    mask |= unsigned(group[i] < 0) << i;
+  return mask;
+#endif
+}
+
+} // namespace detail
+
+// open-addressing hash map in the Swiss table layout: one Array of control bytes and one Array of
+// slots, probed 16 control bytes at a time with SIMD compares. Growth rebuilds into a new table
+// and swaps it in, the same copy-and-swap discipline as Array, so a throwing element copy leaves
+// the map as it was
+template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K> >
+class FlatHashMap
+{
+public:
+  typedef std::pair<const K, V> value_type;
+
+private:
+  typedef typename std::aligned_storage<sizeof(value_type), std::alignment_of<value_type>::value>::type Slot;
+
+  template<typename Value>
+  class BasicIterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    BasicIterator(const signed char* control, const signed char* end, Value* slot)
+      : m_control(control)
+      , m_end(end)
+      , m_slot(slot)
+    {
+      skipFree();
+    }
+
+    // iterator -> const_iterator
+    template<typename Other>
+    BasicIterator(const BasicIterator<Other>& other,
+                  typename std::enable_if<std::is_same<const Other, Value>::value && !std::is_same<Other, Value>::value>::type* = nullptr)
+      : m_control(other.m_control)
+      , m_end(other.m_end)
+      , m_slot(other.m_slot)
+    {
+    }
+
+    Value& operator *() const
+    {
+      return *m_slot;
+    }
+
+    Value* operator ->() const
+    {
+      return m_slot;
+    }
+
+    BasicIterator& operator ++()
+    {
+      ++m_control;
+      ++m_slot;
+      skipFree();
+      return *this;
+    }
+
+    BasicIterator operator ++(int)
+    {
+      BasicIterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator ==(const BasicIterator& other) const
+    {
+      return m_control == other.m_control;
+    }
+
+    bool operator !=(const BasicIterator& other) const
+    {
+      return m_control != other.m_control;
+    }
+
+  private:
+    template<typename>
+    friend class BasicIterator;
+
+    void skipFree()
+    {
+      while(m_control != m_end && *m_control < 0)
+      {
+        ++m_control;
+        ++m_slot;
+      }
+    }
+
+    const signed char* m_control;
+    const signed char* m_end;
+    Value* m_slot;
+  };
+
+public:
+  typedef BasicIterator<value_type> iterator;
+  typedef BasicIterator<const value_type> const_iterator;
+
+  FlatHashMap()
+    : m_size(0)
+    , m_growthLeft(0)
+  {
+  }
+
+  // copy-constructor
+  FlatHashMap(const FlatHashMap& other)
+    : FlatHashMap(other.capacity(), other.m_hash, other.m_equal)
+  {
+    // this object is fully constructed here, a throwing copy destroys what was already copied
+    for(size_t i = 0; i < other.capacity(); ++i)
+      if(other.m_control[i] >= 0)
+      {
+        new (&m_slots[i]) value_type(*other.slot(i));
+        m_control[i] = other.m_control[i];
+        ++m_size;
+      }
+
+    m_growthLeft = other.m_growthLeft;
+    if(capacity())
+      std::memcpy(m_control.data(), other.m_control.data(), capacity());
+  }
+
+  // move constructor
+  FlatHashMap(FlatHashMap&& other)
+    : FlatHashMap()
+  {
+    swap(*this, other);
+  }
+
+  FlatHashMap& operator=(FlatHashMap other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  ~FlatHashMap()
+  {
+    destroySlots(std::is_trivially_destructible<value_type>());
+  }
+
+  void swap(FlatHashMap& first, FlatHashMap& second) // nothrow
+  {
+    first.m_control.swap(first.m_control, second.m_control);
+    first.m_slots.swap(first.m_slots, second.m_slots);
+    std::swap(first.m_size, second.m_size);
+    std::swap(first.m_growthLeft, second.m_growthLeft);
+    std::swap(first.m_hash, second.m_hash);
+    std::swap(first.m_equal, second.m_equal);
+  }
+
+  const size_t size() const
+  {
+    return m_size;
+  }
+
+  bool empty() const
+  {
+    return !m_size;
+  }
+
+  size_t capacity() const
+  {
+    return m_control.size();
+  }
+
+  // makes room for 'count' elements without further rehashing
+  void reserve(const size_t count)
+  {
+    if(count > m_size + m_growthLeft)
+      rehash(capacityFor(count));
+  }
+
+  V* find(const K& key)
+  {
+    const size_t index = findIndex(key, hashOf(key));
+    return index == NOT_FOUND ? nullptr : &slot(index)->second;
+  }
+
+  const V* find(const K& key) const
+  {
+    const size_t index = findIndex(key, hashOf(key));
+    return index == NOT_FOUND ? nullptr : &slot(index)->second;
+  }
+
+  bool contains(const K& key) const
+  {
+    return find(key) != nullptr;
+  }
+
+  // inserts a copy of (key, value) unless the key is present; returns whether it was inserted
+  bool insert(const K& key, const V& value)
+  {
+    const size_t hash = hashOf(key);
+    if(findIndex(key, hash) != NOT_FOUND)
+      return false;
+
+    emplaceNew(hash, key, value);
+    return true;
+  }
+
+  V& operator [](const K& key)
+  {
+    const size_t hash = hashOf(key);
+    const size_t index = findIndex(key, hash);
+    if(index != NOT_FOUND)
+      return slot(index)->second;
+
+    return emplaceNew(hash, key, V())->second;
+  }
+
+  bool erase(const K& key)
+  {
+    const size_t index = findIndex(key, hashOf(key));
+    if(index == NOT_FOUND)
+      return false;
+
+    slot(index)->~value_type();
+    --m_size;
+
+    // a probe only continues past a group without empty slots, so if this group still has one
+    // nobody can be probing through it and the slot may become empty again
+    const size_t group = index / detail::GROUP_SIZE * detail::GROUP_SIZE;
+    if(detail::groupMatch(m_control.data() + group, detail::SLOT_EMPTY))
+    {
+      m_control[index] = detail::SLOT_EMPTY;
+      ++m_growthLeft;
+    }
+    else
+      m_control[index] = detail::SLOT_DELETED;
+
+    return true;
+  }
+
+  void clear()
+  {
+    FlatHashMap empty(m_hash, m_equal);
+    swap(*this, empty);
+  }
+
+  iterator begin()
+  {
+    return iterator(m_control.data(), m_control.data() + capacity(), slot(0));
+  }
+
+  iterator end()
+  {
+    return iterator(m_control.data() + capacity(), m_control.data() + capacity(), slot(capacity()));
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(m_control.data(), m_control.data() + capacity(), slot(0));
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(m_control.data() + capacity(), m_control.data() + capacity(), slot(capacity()));
+  }
+
+private:
+  static const size_t NOT_FOUND = ~size_t(0);
+
+  FlatHashMap(const Hash& hash, const Equal& equal)
+    : m_size(0)
+    , m_growthLeft(0)
+    , m_hash(hash)
+    , m_equal(equal)
+  {
+  }
+
+  // empty table with 'capacity' slots (zero or a power of two not below the group size)
+  FlatHashMap(const size_t capacity, const Hash& hash, const Equal& equal)
+    : m_control(capacity, Uninitialized())
+    , m_slots(capacity, Uninitialized())
+    , m_size(0)
+    , m_growthLeft(capacity - capacity / 8)
+    , m_hash(hash)
+    , m_equal(equal)
+  {
+    if(capacity)
+      std::memset(m_control.data(), detail::SLOT_EMPTY, capacity);
+  }
+
+  static size_t capacityFor(const size_t count)
+  {
+    size_t capacity = detail::GROUP_SIZE;
+    while(capacity - capacity / 8 < count)
+      capacity *= 2;
+    return capacity;
+  }
+
+  // std::hash of integers is the identity on common implementations, so mix before splitting
+  // the hash into the group index (high bits) and the control byte (low 7 bits)
+  size_t hashOf(const K& key) const
+  {
+    return static_cast<size_t>(detail::hashMix(m_hash(key)));
+  }
+
+  value_type* slot(const size_t index)
+  {
+    return reinterpret_cast<value_type*>(m_slots.data() + index);
+  }
+
+  const value_type* slot(const size_t index) const
+  {
+    return reinterpret_cast<const value_type*>(m_slots.data() + index);
+  }
+
+  // groups are visited in triangular order, which covers every group of a power of two table
+  size_t findIndex(const K& key, const size_t hash) const
+  {
+    if(!capacity())
+      return NOT_FOUND;
+
+    const size_t groupMask = capacity() / detail::GROUP_SIZE - 1;
+    const signed char tag = static_cast<signed char>(hash & 0x7f);
+
+    for(size_t group = (hash >> 7) & groupMask, step = 1; ; group = (group + step++) & groupMask)
+    {
+      const signed char* control = m_control.data() + group * detail::GROUP_SIZE;
+
+      for(unsigned match = detail::groupMatch(control, tag); match; match &= match - 1)
+      {
+        const size_t index = group * detail::GROUP_SIZE + detail::lowestBit(match);
+        if(m_equal(slot(index)->first, key))
+          return index;
+      }
+
+      if(detail::groupMatch(control, detail::SLOT_EMPTY))
+        return NOT_FOUND;
+    }
+  }
+
+  size_t findFree(const size_t hash) const
+  {
+    const size_t groupMask = capacity() / detail::GROUP_SIZE - 1;
+
+    for(size_t group = (hash >> 7) & groupMask, step = 1; ; group = (group + step++) & groupMask)
+    {
+      const unsigned free = detail::groupMatchFree(m_control.data() + group * detail::GROUP_SIZE);
+      if(free)
+        return group * detail::GROUP_SIZE + detail::lowestBit(free);
+    }
+  }
+
+  // constructs the element first and publishes its control byte after, so a throwing
+  // constructor leaves the table unchanged; when the table is full the new element goes into the
+  // rebuilt table before the old elements, so 'args' may refer to elements of this map
+  template<typename... Args>
+  value_type* emplaceNew(const size_t hash, Args&&... args)
+  {
+    if(!m_growthLeft)
+    {
+      FlatHashMap fresh(m_size + 1 > capacity() / 2 ? capacityFor(capacity() + 1) : capacity(), m_hash, m_equal);
+      value_type* element = fresh.emplaceNew(hash, std::forward<Args>(args)...);
+      fresh.insertAll(*this);
+      swap(*this, fresh);
+      return element;
+    }
+
+    const size_t index = findFree(hash);
+    value_type* element = new (&m_slots[index]) value_type(std::forward<Args>(args)...);
+
+    if(m_control[index] == detail::SLOT_EMPTY)
+      --m_growthLeft;
+    m_control[index] = static_cast<signed char>(hash & 0x7f);
+    ++m_size;
+
+    return element;
+  }
+
+  // adds every element of 'other' (whose keys are all absent here); elements are moved only
+  // when that cannot throw, so 'other' survives a failed copy untouched
+  void insertAll(FlatHashMap& other)
+  {
+    for(size_t i = 0; i < other.capacity(); ++i)
+      if(other.m_control[i] >= 0)
+      {
+        const size_t hash = hashOf(other.slot(i)->first);
+        const size_t index = findFree(hash);
+        new (&m_slots[index]) value_type(std::move_if_noexcept(*other.slot(i)));
+        m_control[index] = static_cast<signed char>(hash & 0x7f);
+        --m_growthLeft;
+        ++m_size;
+      }
+  }
+
+  void rehash(const size_t newCapacity)
+  {
+    FlatHashMap fresh(std::max(newCapacity, capacityFor(m_size)), m_hash, m_equal);
+    fresh.insertAll(*this);
+    swap(*this, fresh);
+  }
+
+  void destroySlots(std::true_type)
+  {
+  }
+
+  void destroySlots(std::false_type)
+  {
+    for(size_t i = 0; i < capacity(); ++i)
+      if(m_control[i] >= 0)
+        slot(i)->~value_type();
+  }
+
+  Array<signed char> m_control;
+  Array<Slot> m_slots;
+  size_t m_size;
+  size_t m_growthLeft;
+  Hash m_hash;
+  Equal m_equal;
+};
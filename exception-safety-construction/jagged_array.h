@@ -0,0 +1,183 @@
+#pragma once
+
+#include "array.h"
+#include "array_view.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <utility> // std::move
+
+const size_t PARALLEL_JAGGED_GRAIN = 1 << 14;
+
+namespace detail
+{
+
+// offsets[0] = 0, offsets[i + 1] = offsets[i] + sizes[i]; every thread sums its chunk, the chunk
+// totals are scanned serially and every thread then writes its chunk starting from its base
+inline void parallelOffsets(const size_t* sizes, size_t* offsets, const size_t count, const size_t scanThreads)
+{
+  const size_t threads = parallelThreadCount(count, PARALLEL_JAGGED_GRAIN, scanThreads);
+  Array<size_t> bases(threads + 1);
+
+  parallelFor(count, threads, [&](const size_t thread, const size_t begin, const size_t end)
+  {
+    size_t total = 0;
+    for(size_t i = begin; i < end; ++i)
+      total += sizes[i];
+    bases[thread + 1] = total;
+  });
+
+  for(size_t thread = 0; thread < threads; ++thread)
+    bases[thread + 1] += bases[thread];
+
+  offsets[0] = 0;
+  parallelFor(count, threads, [&](const size_t thread, const size_t begin, const size_t end)
+  {
+    size_t offset = bases[thread];
+    for(size_t i = begin; i < end; ++i)
+    {
+      offset += sizes[i];
+      offsets[i + 1] = offset;
+    }
+  });
+}
+
+} // namespace detail
+
+// array of variable-length rows in compressed sparse row layout: all rows share one values Array,
+// row i is values[offsets[i], offsets[i + 1]). Two allocations in total instead of one per row,
+// rows are adjacent in memory and a copy is one bulk copy of each buffer
+template<typename T>
+class JaggedArray
+{
+public:
+  // no rows; like a moved-from JaggedArray it holds no offsets either, so neither allocates
+  JaggedArray() noexcept
+  {
+  }
+
+  // value-initialized rows of the given sizes. Here and below 'threads' overrides the thread
+  // count picked from the size and hardwareThreads()
+  explicit JaggedArray(const Array<size_t>& rowSizes, const size_t threads = 0)
+    : m_offsets(offsetsFor(rowSizes, threads))
+    , m_values(m_offsets[rowSizes.size()])
+  {
+  }
+
+  // rows of the given sizes filled by fill(rowIndex, ArrayView<T>) on several threads; the
+  // values buffer is only default-initialized, so fill must assign every element
+  template<typename Fill, typename = typename std::enable_if<!std::is_integral<Fill>::value>::type>
+  JaggedArray(const Array<size_t>& rowSizes, Fill fill, const size_t threads = 0)
+    : m_offsets(offsetsFor(rowSizes, threads))
+    , m_values(m_offsets[rowSizes.size()], Uninitialized())
+  {
+    const size_t count = rows();
+    parallelFor(count, parallelThreadCount(m_values.size(), PARALLEL_JAGGED_GRAIN, threads),
+                [&](const size_t, const size_t begin, const size_t end)
+    {
+      for(size_t row = begin; row < end; ++row)
+        fill(row, (*this)[row]);
+    });
+  }
+
+  // flattens a nested Array, the migration path from Array<Array<T>>
+  explicit JaggedArray(const Array<Array<T> >& nested, const size_t threads = 0)
+    : JaggedArray(rowSizesOf(nested), [&nested](const size_t row, ArrayView<T> values)
+      {
+        std::copy(nested[row].begin(), nested[row].end(), values.begin());
+      }, threads)
+  {
+  }
+
+  JaggedArray& operator=(JaggedArray other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  // move constructor
+  JaggedArray(JaggedArray&& other) noexcept
+    : m_offsets(std::move(other.m_offsets))
+    , m_values(std::move(other.m_values))
+  {
+  }
+
+  // copy-constructor: one bulk copy per buffer
+  JaggedArray(const JaggedArray& other)
+    : m_offsets(other.m_offsets)
+    , m_values(other.m_values)
+  {
+  }
+
+  void swap(JaggedArray& first, JaggedArray& second) // nothrow
+  {
+    first.m_offsets.swap(first.m_offsets, second.m_offsets);
+    first.m_values.swap(first.m_values, second.m_values);
+  }
+
+  size_t rows() const
+  {
+    return m_offsets.size() ? m_offsets.size() - 1 : 0;
+  }
+
+  // total number of elements over all rows
+  const size_t size() const
+  {
+    return m_values.size();
+  }
+
+  size_t rowSize(const size_t row) const
+  {
+    return m_offsets[row + 1] - m_offsets[row];
+  }
+
+  ArrayView<T> operator [](const size_t row)
+  {
+    assert(row < rows());
+
+    return ArrayView<T>(m_values.data() + m_offsets[row], rowSize(row));
+  }
+
+  ArrayView<const T> operator [](const size_t row) const
+  {
+    assert(row < rows());
+
+    return ArrayView<const T>(m_values.data() + m_offsets[row], rowSize(row));
+  }
+
+  const Array<T>& values() const
+  {
+    return m_values;
+  }
+
+  Array<T>& values()
+  {
+    return m_values;
+  }
+
+  // rows() + 1 offsets, none for a default-constructed or moved-from JaggedArray
+  const Array<size_t>& offsets() const
+  {
+    return m_offsets;
+  }
+
+private:
+  static Array<size_t> offsetsFor(const Array<size_t>& rowSizes, const size_t threads)
+  {
+    Array<size_t> offsets(rowSizes.size() + 1, Uninitialized());
+    detail::parallelOffsets(rowSizes.data(), offsets.data(), rowSizes.size(), threads);
+    return offsets;
+  }
+
+  static Array<size_t> rowSizesOf(const Array<Array<T> >& nested)
+  {
+    Array<size_t> sizes(nested.size(), Uninitialized());
+    for(size_t row = 0; row < nested.size(); ++row)
+      sizes[row] = nested[row].size();
+    return sizes;
+  }
+
+  Array<size_t> m_offsets;
+  Array<T> m_values;
+};
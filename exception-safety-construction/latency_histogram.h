@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <vector>
+
+// HDR-style histogram of latencies in nanoseconds: values below 2^SUB_BUCKET_BITS get a bucket
+// each, above that every power of two is split into 2^(SUB_BUCKET_BITS - 1) equal buckets, so
+// any recorded value is known to within 1/64 over the whole 64-bit range. Recording is an
+// increment, the memory is a fixed few thousand counters
+class LatencyHistogram
+{
+public:
+  static const unsigned SUB_BUCKET_BITS = 7;
+
+  LatencyHistogram()
+    : m_counts(bucketIndex(UINT64_MAX) + 1)
+    , m_total(0)
+    , m_max(0)
+  {
+  }
+
+  void record(const uint64_t nanoseconds)
+  {
+    ++m_counts[bucketIndex(nanoseconds)];
+    ++m_total;
+    if(nanoseconds > m_max)
+      m_max = nanoseconds;
+  }
+
+  uint64_t count() const
+  {
+    return m_total;
+  }
+
+  uint64_t max() const
+  {
+    return m_max;
+  }
+
+  // smallest recorded bucket bound below which 'percent' of the values fall, reported as the
+  // highest value of that bucket (never above max())
+  uint64_t percentile(const double percent) const
+  {
+    if(!m_total)
+      return 0;
+
+    uint64_t wanted = static_cast<uint64_t>(percent / 100 * m_total + 0.5);
+    if(wanted < 1)
+      wanted = 1;
+
+    uint64_t seen = 0;
+    for(size_t index = 0; index < m_counts.size(); ++index)
+    {
+      seen += m_counts[index];
+      if(seen >= wanted)
+      {
+        const uint64_t high = bucketHigh(index);
+        return high < m_max ? high : m_max;
+      }
+    }
+
+    return m_max;
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    for(size_t index = 0; index < m_counts.size(); ++index)
+      m_counts[index] += other.m_counts[index];
+
+    m_total += other.m_total;
+    if(other.m_max > m_max)
+      m_max = other.m_max;
+  }
+
+  void reset()
+  {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_total = 0;
+    m_max = 0;
+  }
+
+private:
+  static const uint64_t EXACT = uint64_t(1) << SUB_BUCKET_BITS;
+  static const uint64_t HALF = EXACT / 2;
+
+  static unsigned highestBit(const uint64_t value)
+  {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned bit = 0;
+    for(uint64_t rest = value; rest >>= 1; )
+      ++bit;
+    return bit;
+#endif
+  }
+
+  static size_t bucketIndex(const uint64_t value)
+  {
+    if(value < EXACT)
+      return static_cast<size_t>(value);
+
+    const unsigned shift = highestBit(value) - SUB_BUCKET_BITS + 1;
+    return static_cast<size_t>(shift * HALF + (value >> shift));
+  }
+
+  static uint64_t bucketHigh(const size_t index)
+  {
+    if(index < EXACT)
+      return index;
+
+    const unsigned shift = static_cast<unsigned>(index / HALF - 1);
+    const uint64_t sub = index - shift * HALF;
+    return ((sub + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> m_counts;
+  uint64_t m_total;
+  uint64_t m_max;
+};
@@ -1,7 +1,14 @@
 ///////////////////////// header //////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <bitset>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <unordered_set>
 
 static int g_instance_counter = 0;
 static int g_memory_usage = 0;
@@ -9,95 +16,26 @@ static bool g_throw_on_constructor = false;
 
 ///////////////////////// code //////////////////////////////////////////////////////////
 
-#include <assert.h>
-#include <algorithm> // std::copy
-#include <cstddef> // size_t
-
-template<typename T>
-class Array
-{
-public:
-  // (default) constructor
-  Array(const size_t size = 0)
-    : m_size(size)
-    , m_array(m_size ? new T[m_size]() : nullptr)
-  {
-  }
-
-//  // unsafe version
-//  Array& operator=(const Array& other)
-//  {
-//    if(&other != this)
-//    {
-//      delete [] m_array;
-//      m_size = other.m_size;
-//      m_array = new T[m_size];
-//      std::copy(other.m_array, other.m_array + m_size, m_array);
-//    }
-//    return *this;
-//  }
-
-  // safe version
-  Array& operator=(Array other)
-  {
-    swap(*this, other);
-    return *this;
-  }
-
-  // move constructor
-  Array(Array&& other)
-    : Array()
-  {
-    swap(*this, other);
-  }
-
-  // copy-constructor
-  Array(const Array& other)
-    : m_size(other.m_size),
-      m_array(m_size ? new T[m_size] : nullptr)
-  {
-    //std::copy(other.m_array.get(), other.m_array.get() + m_size, m_array.get());
-
-    try
-    {
-      std::copy(other.m_array, other.m_array + m_size, m_array);
-    }
-    catch(...)
-    {
-      delete [] m_array;
-      throw;
-    }
-  }
-
-  // destructor
-  ~Array()
-  {
-    delete [] m_array;
-  }
-
-  void swap(Array& first, Array& second) // nothrow
-  {
-    std::swap(first.m_size, second.m_size);
-    std::swap(first.m_array, second.m_array);
-  }
-
-  const size_t size() const
-  {
-    return m_size;
-  }
-
-  T& operator [](const size_t index)
-  {
-    assert(index < m_size);
-
-    return m_array[index];
-  }
-
-private:
-  size_t m_size;
-  T* m_array;
-  //std::unique_ptr<T[]> m_array;
-};
+#include "array.h"
+#include "array_alloc_profile.h"
+#include "array_compressed.h"
+#include "array_frozen.h"
+#include "array_hash.h"
+#include "array_histogram.h"
+#include "array_incremental.h"
+#include "array_merge.h"
+#include "array_numa.h"
+#include "array_permute.h"
+#include "array_pool.h"
+#include "array_prefetch.h"
+#include "array_small.h"
+#include "array_sort.h"
+#include "benchmark_baseline.h"
+#include "flat_hash_map.h"
+#include "jagged_array.h"
+#include "latency_histogram.h"
+#include "slot_map.h"
+#include "spsc_ring.h"
 
 ///////////////////////// footer //////////////////////////////////////////////////////////
 
@@ -244,16 +182,1261 @@ void checkObjectsDestruction()
   }
 }
 
-int main(int argc, char *argv[])
-try
+// thread counts the parallel kernels are tested with, whatever the machine has: one runs the
+// serial path, the others the slicing and combining of partial results
+const size_t TEST_THREADS[] = { 1, 4, 7 };
+const size_t TEST_THREAD_COUNTS = sizeof(TEST_THREADS) / sizeof(TEST_THREADS[0]);
+
+void sortTest()
 {
-  logicTest();
-  checkObjectsDestruction();
+  const size_t SIZE = 300000;
 
-  safetyTest();
-  checkObjectsDestruction();
+  Array<int> input(SIZE);
+  Array<std::pair<int, int> > unsortedRecords(SIZE);
 
-  safetyTest(true);
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    input[i] = static_cast<int>((i * 2654435761u) % 100003) - 50000;
+    unsortedRecords[i] = std::make_pair(input[i] % 7, static_cast<int>(i));
+  }
+
+  Array<int> expected = input;
+  std::sort(expected.begin(), expected.end());
+
+  Array<int> values;
+  for(size_t t = 0; t < TEST_THREAD_COUNTS; ++t)
+  {
+    const size_t threads = TEST_THREADS[t];
+    values = input;
+    Array<double> reals(SIZE);
+    for(size_t i = 0; i < SIZE; ++i)
+      reals[i] = values[i] * 0.5;
+
+    parallelSort(values, threads);
+    parallelSort(reals, threads);
+
+    for(size_t i = 0; i < SIZE; ++i)
+      if(values[i] != expected[i] || reals[i] != expected[i] * 0.5)
+      {
+        std::cout << "parallel sort test failure" << std::endl;
+        exit(EXIT_SUCCESS);
+      }
+
+    Array<std::pair<int, int> > records = unsortedRecords;
+    parallelStableSort(records, [](const std::pair<int, int>& left, const std::pair<int, int>& right)
+    {
+      return left.first < right.first;
+    }, threads);
+
+    for(size_t i = 1; i < SIZE; ++i)
+      if(records[i - 1].first > records[i].first
+         || (records[i - 1].first == records[i].first && records[i - 1].second > records[i].second))
+      {
+        std::cout << "stable sort test failure" << std::endl;
+        exit(EXIT_SUCCESS);
+      }
+  }
+
+  for(int value = -50010; value <= 50010; value += 37)
+    if(lowerBound(values, value) != static_cast<size_t>(std::lower_bound(values.begin(), values.end(), value) - values.begin()))
+    {
+      std::cout << "lower bound test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+}
+
+void mergeTest()
+{
+  const size_t SHARDS = 23;
+
+  Array<Array<int> > shards(SHARDS);
+  Array<int> all;
+
+  for(size_t s = 0; s < SHARDS; ++s)
+  {
+    Array<int> shard(s * 1700);
+    for(size_t i = 0; i < shard.size(); ++i)
+      shard[i] = static_cast<int>((i * 7919 + s * 104729) % 5000);
+    std::sort(shard.begin(), shard.end());
+    shards[s] = shard;
+
+    Array<int> joined(all.size() + shard.size());
+    std::copy(shard.begin(), shard.end(), std::copy(all.begin(), all.end(), joined.begin()));
+    all = joined;
+  }
+
+  std::sort(all.begin(), all.end());
+  checkSize(kWayMerge(shards), all.size(), "k-way merge test failure (check size)");
+
+  const Array<int>& first = shards[SHARDS - 1];
+  const Array<int>& second = shards[SHARDS - 2];
+  Array<int> expected(first.size() + second.size());
+
+  for(size_t t = 0; t < TEST_THREAD_COUNTS; ++t)
+  {
+    const size_t threads = TEST_THREADS[t];
+
+    Array<int> merged = kWayMerge(shards.data(), shards.size(), std::less<int>(), threads);
+
+    checkSize(merged, all.size(), "k-way merge test failure (check size)");
+    if(!std::equal(all.begin(), all.end(), merged.begin()))
+    {
+      std::cout << "k-way merge test failure (check data)" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+    Array<int> united = setUnion(first, second, std::less<int>(), threads);
+    checkSize(united, std::set_union(first.begin(), first.end(), second.begin(), second.end(), expected.begin()) - expected.begin(),
+              "set union test failure (check size)");
+    if(!std::equal(united.begin(), united.end(), expected.begin()))
+    {
+      std::cout << "set union test failure (check data)" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+    Array<int> common = setIntersection(first, second, std::less<int>(), threads);
+    checkSize(common, std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), expected.begin()) - expected.begin(),
+              "set intersection test failure (check size)");
+    if(!std::equal(common.begin(), common.end(), expected.begin()))
+    {
+      std::cout << "set intersection test failure (check data)" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+    Array<int> difference = setDifference(first, second, std::less<int>(), threads);
+    checkSize(difference, std::set_difference(first.begin(), first.end(), second.begin(), second.end(), expected.begin()) - expected.begin(),
+              "set difference test failure (check size)");
+    if(!std::equal(difference.begin(), difference.end(), expected.begin()))
+    {
+      std::cout << "set difference test failure (check data)" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+    // more threads than elements
+    checkSize(setUnion(Array<int>(), Array<int>(1), std::less<int>(), threads), 1, "set union test failure (check size)");
+  }
+}
+
+void permuteTest()
+{
+  const size_t SIZE = 200003;
+
+  Array<unsigned> permutation(SIZE);
+  Array<int> values(SIZE);
+  Array<std::string> names(SIZE);
+
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    permutation[i] = static_cast<unsigned>((i * 7919) % SIZE);
+    values[i] = static_cast<int>(i);
+    names[i] = std::to_string(i);
+  }
+
+  Array<int> gathered = gather(values, permutation);
+  for(size_t i = 0; i < SIZE; ++i)
+    if(gathered[i] != static_cast<int>(permutation[i]))
+    {
+      std::cout << "gather test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+  Array<int> scattered(SIZE);
+  scatter(gathered, permutation, scattered);
+  checkData(scattered, "scatter test failure");
+
+  applyPermutation(values, permutation);
+  applyPermutationInPlace(names, permutation);
+  for(size_t i = 0; i < SIZE; ++i)
+    if(values[i] != gathered[i] || names[i] != std::to_string(permutation[i]))
+    {
+      std::cout << "apply permutation test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+}
+
+void histogramTest()
+{
+  const size_t SIZE = 500001;
+  const int MIN_VALUE = -100;
+  const int MAX_VALUE = 899;
+
+  Array<int> values(SIZE);
+  Array<size_t> expected(MAX_VALUE - MIN_VALUE + 1);
+  Array<size_t> expectedBins(10);
+
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    values[i] = static_cast<int>((i * i) % 1201) - 150;
+    if(values[i] >= MIN_VALUE && values[i] <= MAX_VALUE)
+    {
+      ++expected[values[i] - MIN_VALUE];
+      ++expectedBins[(values[i] - MIN_VALUE) / 100];
+    }
+  }
+
+  for(size_t t = 0; t < TEST_THREAD_COUNTS; ++t)
+  {
+    Array<size_t> counts = countValues(values, MIN_VALUE, MAX_VALUE, TEST_THREADS[t]);
+    Array<size_t> bins = histogram(values, MIN_VALUE, MAX_VALUE + 1, 10, TEST_THREADS[t]);
+
+    checkSize(counts, expected.size(), "counting test failure (check size)");
+    checkSize(bins, expectedBins.size(), "histogram test failure (check size)");
+    if(!std::equal(counts.begin(), counts.end(), expected.begin()) || !std::equal(bins.begin(), bins.end(), expectedBins.begin()))
+    {
+      std::cout << "histogram test failure (check data)" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+  }
+}
+
+void hashTest()
+{
+  const size_t SIZE = 1027;
+
+  Array<int> values(SIZE);
+  Array<double> reals(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    values[i] = static_cast<int>(i);
+    reals[i] = -static_cast<double>(i);
+  }
+
+  Array<int> same = values;
+  Array<double> sameReals = reals;
+  sameReals[0] = 0.0; // -0.0 == 0.0
+
+  if(!(same == values) || hashArray(same) != hashArray(values)
+     || !(sameReals == reals) || hashArray(sameReals) != hashArray(reals))
+  {
+    std::cout << "equal arrays compare or hash differently" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  same[SIZE - 1] = 0;
+  if(same == values || hashArray(same) == hashArray(values))
+  {
+    std::cout << "different arrays compare or hash equal" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  std::unordered_set<HashedArray<int> > unique;
+  unique.insert(HashedArray<int>(values));
+  unique.insert(HashedArray<int>(same));
+  unique.insert(HashedArray<int>(values));
+
+  if(unique.size() != 2 || !unique.count(HashedArray<int>(same)))
+  {
+    std::cout << "hashed array dedupe test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void hashMapTest()
+{
+  const int KEYS = 20000;
+
+  FlatHashMap<int, std::string> map;
+  for(int key = 0; key < KEYS; ++key)
+    map.insert(key * 3, std::to_string(key));
+
+  for(int key = 0; key < KEYS; key += 2)
+    map.erase(key * 3);
+
+  map.insert(1, map[3]);
+
+  if(map.size() != KEYS / 2 + 1 || !map.contains(1) || *map.find(1) != "1" || map.find(6) || map.insert(9, "x"))
+  {
+    std::cout << "flat hash map test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  FlatHashMap<int, std::string> copy = map;
+  size_t visited = 0;
+  for(FlatHashMap<int, std::string>::const_iterator it = copy.begin(); it != copy.end(); ++it, ++visited)
+    if(!map.find(it->first) || *map.find(it->first) != it->second)
+    {
+      std::cout << "flat hash map copy test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+  checkSize(Array<int>(visited), map.size(), "flat hash map iteration test failure");
+
+  // a throwing element copy during assignment leaves the target untouched
+  g_throw_on_constructor = false;
+
+  FlatHashMap<int, Array<Foo> > foos;
+  FlatHashMap<int, Array<Foo> > target;
+  for(int key = 0; key < 10; ++key)
+  {
+    foos[key] = Array<Foo>(2);
+    target[key] = Array<Foo>(key + 1);
+  }
+
+  bool exceptionCatched = false;
+  try
+  {
+    target = foos;
+  }
+  catch(const std::exception&)
+  {
+    exceptionCatched = true;
+  }
+
+  for(int key = 0; key < 10; ++key)
+    if(!exceptionCatched || !target.find(key) || target.find(key)->size() != static_cast<size_t>(key + 1))
+    {
+      std::cout << "flat hash map safety test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+}
+
+void slotMapTest()
+{
+  const size_t COUNT = 1000;
+
+  SlotMap<std::string> map;
+  Array<SlotHandle> handles(COUNT);
+  for(size_t i = 0; i < COUNT; ++i)
+    handles[i] = map.insert(std::to_string(i));
+
+  for(size_t i = 0; i < COUNT; i += 3)
+    map.erase(handles[i]);
+
+  // reused slots must not revive the erased handles
+  const SlotHandle first = map.insert(*map.find(handles[1]));
+
+  for(size_t i = 0; i < COUNT; ++i)
+    if((i % 3 == 0) != !map.find(handles[i]) || (i % 3 && *map.find(handles[i]) != std::to_string(i)))
+    {
+      std::cout << "slot map handle test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+
+  SlotMap<std::string> copy = map;
+  if(copy.size() != COUNT - (COUNT + 2) / 3 + 1 || !copy.find(first) || *copy.find(first) != "1"
+     || copy.find(copy.handleAt(copy.size() - 1)) != copy.end() - 1)
+  {
+    std::cout << "slot map copy test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void ringTest()
+{
+  const size_t COUNT = 200000;
+  const size_t BATCH = 7;
+
+  static_assert(alignof(SpscRing<std::string>) <= alignof(std::max_align_t), "SpscRing must not need over-aligned new");
+
+  SpscRing<std::string> ring(100);
+  bool ordered = true;
+  std::atomic<bool> running(true);
+  bool bounded = true;
+
+  // neither side: the size it sees must stay within the ring while both move
+  std::thread observer([&]()
+  {
+    while(running.load(std::memory_order_relaxed))
+      bounded = bounded && ring.sizeApprox() <= ring.capacity();
+  });
+
+  std::thread consumer([&]()
+  {
+    std::string values[BATCH];
+    size_t expected = 0;
+
+    while(expected < COUNT)
+    {
+      const size_t popped = expected % 2 ? ring.popBatch(values, BATCH) : ring.tryPop(values[0]);
+      if(!popped)
+        std::this_thread::yield();
+
+      for(size_t i = 0; i < popped; ++i)
+        ordered = ordered && values[i] == std::to_string(expected++);
+    }
+  });
+
+  for(size_t next = 0; next < COUNT; )
+  {
+    std::string values[BATCH];
+    for(size_t i = 0; i < BATCH; ++i)
+      values[i] = std::to_string(next + i);
+
+    const size_t pushed = next % 3 ? ring.pushBatch(values, std::min(BATCH, COUNT - next)) : ring.tryPush(values[0]);
+    if(!pushed)
+      std::this_thread::yield();
+    next += pushed;
+  }
+
+  consumer.join();
+  running.store(false, std::memory_order_relaxed);
+  observer.join();
+
+  if(!ordered || !bounded || ring.capacity() != 128 || ring.sizeApprox())
+  {
+    std::cout << "spsc ring test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void jaggedTest()
+{
+  const size_t ROWS = 1000;
+
+  Array<Array<int> > nested(ROWS);
+  Array<size_t> rowSizes(ROWS);
+  for(size_t row = 0; row < ROWS; ++row)
+  {
+    rowSizes[row] = row % 7;
+    nested[row] = Array<int>(rowSizes[row]);
+    for(size_t i = 0; i < rowSizes[row]; ++i)
+      nested[row][i] = static_cast<int>(row * 10 + i);
+  }
+
+  for(size_t t = 0; t < TEST_THREAD_COUNTS; ++t)
+  {
+    const size_t threads = TEST_THREADS[t];
+
+    const JaggedArray<int> flattened(nested, threads);
+    const JaggedArray<int> filled(rowSizes, [](const size_t row, ArrayView<int> values)
+    {
+      for(size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<int>(row * 10 + i);
+    }, threads);
+
+    JaggedArray<int> copy;
+    copy = filled;
+
+    JaggedArray<int> source = filled;
+    const JaggedArray<int> moved(std::move(source));
+    const bool emptied = !source.rows() && !source.size() && !JaggedArray<int>().rows() && moved.rows() == ROWS;
+
+    bool equal = flattened.rows() == ROWS && copy.size() == flattened.size()
+                 && copy.offsets()[ROWS] == copy.size();
+    for(size_t row = 0; equal && row < ROWS; ++row)
+    {
+      const ArrayView<const int> values = copy[row];
+      equal = values.size() == nested[row].size() && flattened.rowSize(row) == values.size()
+              && std::equal(values.begin(), values.end(), nested[row].begin())
+              && std::equal(values.begin(), values.end(), flattened[row].begin());
+    }
+
+    if(!equal || !emptied || copy.values().data() == filled.values().data() || JaggedArray<int>(Array<size_t>(3), threads).size())
+    {
+      std::cout << "jagged array test failure" << std::endl;
+      exit(EXIT_SUCCESS);
+    }
+  }
+}
+
+void moveOnlyTest()
+{
+  const size_t SIZE = 100;
+
+  static_assert(!std::is_copy_constructible<Array<std::unique_ptr<int> > >::value
+                && !std::is_copy_assignable<Array<std::unique_ptr<int> > >::value
+                && !std::is_copy_constructible<Array<Array<std::unique_ptr<int> > > >::value,
+                "Arrays of move-only elements must be move-only");
+  static_assert(std::is_copy_constructible<Array<int> >::value && std::is_copy_assignable<Array<int> >::value
+                && std::is_move_assignable<Array<std::unique_ptr<int> > >::value,
+                "Arrays of copyable elements must be copyable");
+
+  Array<std::unique_ptr<int> > source(SIZE);
+  for(size_t i = 0; i < source.size(); ++i)
+    source[i].reset(new int(static_cast<int>(i)));
+
+  const int* first = source[0].get();
+  Array<std::unique_ptr<int> > target(SIZE / 2);
+  target = std::move(source);
+
+  Array<Array<std::unique_ptr<int> > > nested(2);
+  nested[1] = std::move(target);
+
+  bool moved = !source.size() && !target.size() && nested[1].size() == SIZE && nested[1][0].get() == first;
+  for(size_t i = 0; moved && i < SIZE; ++i)
+    moved = *nested[1][i] == static_cast<int>(i);
+
+  // no default constructor and no copy assignment needed
+  const int value = 7;
+  const Array<std::reference_wrapper<const int> > references(3, InPlace(), std::cref(value));
+
+  g_throw_on_constructor = false;
+  {
+    const Array<Foo> foos(SIZE, InPlace(), 3);
+    moved = moved && g_instance_counter == static_cast<int>(SIZE) && foos[SIZE - 1] == 3 && g_memory_usage == 1;
+  }
+
+  if(!moved || &references[2].get() != &value)
+  {
+    std::cout << "move-only element test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void policyTest()
+{
+  const size_t SIZE = 1000;
+
+  Array<int, ThrowBoundsCheck> checked(SIZE);
+  Array<int, NoBoundsCheck> unchecked(SIZE);
+
+  bool thrown = false;
+  try
+  {
+    checked[SIZE] = 1;
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+
+  // calls the check alone, the accesses it lets through would really be out of bounds
+  size_t sampledThrows = 0;
+  for(size_t i = 0; i < 4; ++i)
+    try
+    {
+      SampledBoundsCheck<4>::check(SIZE + i, SIZE);
+    }
+    catch(const std::out_of_range&)
+    {
+      ++sampledThrows;
+    }
+
+  unchecked[SIZE - 1] = 1;
+
+  g_throw_on_constructor = false;
+  Arena arena(4096);
+  bool arenaChecked = false;
+  {
+    ArenaScope scope(arena);
+    Array<Foo, AssertBoundsCheck, ArenaStorage> foos(SIZE);
+    Array<int, AssertBoundsCheck, ArenaStorage> copy(SIZE);
+    copy[SIZE - 1] = 7;
+    const Array<int, AssertBoundsCheck, ArenaStorage> other = copy;
+    arenaChecked = other[SIZE - 1] == 7 && g_instance_counter == static_cast<int>(SIZE) && !g_memory_usage;
+  }
+  arena.release();
+
+  try
+  {
+    Array<int, AssertBoundsCheck, ArenaStorage> outside(SIZE);
+    arenaChecked = false;
+  }
+  catch(const std::logic_error&)
+  {
+  }
+
+  Array<double, AssertBoundsCheck, MmapStorage> mapped(1 << 20);
+  mapped[mapped.size() - 1] = 0.5;
+  const Array<double, AssertBoundsCheck, MmapStorage> mappedCopy = mapped;
+
+  if(!thrown || sampledThrows != 1 || unchecked[SIZE - 1] != 1 || !arenaChecked
+     || mappedCopy[0] != 0 || mappedCopy[mapped.size() - 1] != 0.5)
+  {
+    std::cout << "array policy test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void streamTest()
+{
+  const size_t SIZE = STREAMING_THRESHOLD / sizeof(int) + 37;
+
+  Array<int> source(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+    source[i] = static_cast<int>(i);
+
+  const Array<int> copy = source;
+
+  // misaligned ends on both sides
+  Array<int> shifted(SIZE);
+  streamingCopy(source.data() + 1, shifted.data() + 3, SIZE - 5);
+
+  Array<short> shorts(STREAMING_THRESHOLD / sizeof(short) + 5);
+  shorts.fill(-3);
+
+  Array<std::string> strings(5);
+  strings.fill("stream");
+
+  // 4-byte elements aligned to 2 bytes only, starting 2 bytes past a 4-byte boundary
+  struct ShortPair
+  {
+    short first;
+    short second;
+  };
+  const size_t PAIRS = STREAMING_THRESHOLD / sizeof(ShortPair) + 3;
+  Array<short> halves(2 * PAIRS + 2);
+  const ShortPair pair = { 5, -6 };
+  streamingFill(reinterpret_cast<ShortPair*>(halves.data() + 1), PAIRS, pair);
+
+  bool paired = !halves[0] && !halves[2 * PAIRS + 1];
+  for(size_t i = 0; paired && i < PAIRS; ++i)
+    paired = halves[2 * i + 1] == 5 && halves[2 * i + 2] == -6;
+
+  bool streamed = std::equal(source.begin(), source.end(), copy.begin()) && !shifted[2] && !shifted[SIZE - 2]
+                  && std::equal(source.begin() + 1, source.end() - 4, shifted.begin() + 3)
+                  && std::count(shorts.begin(), shorts.end(), -3) == static_cast<std::ptrdiff_t>(shorts.size())
+                  && strings[4] == "stream" && paired;
+
+  if(!streamed)
+  {
+    std::cout << "streaming copy test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void prefetchedCopyTest()
+{
+  const size_t ROWS = 100;
+
+  Array<Array<int> > nested(ROWS);
+  Array<std::string> strings(ROWS);
+  for(size_t row = 0; row < ROWS; ++row)
+  {
+    nested[row] = Array<int>(row);
+    for(size_t i = 0; i < row; ++i)
+      nested[row][i] = static_cast<int>(row + i);
+    strings[row] = std::string(row, 'x');
+  }
+
+  const Array<Array<int> > copy = prefetchedCopy(nested);
+  const Array<Array<int> > close = prefetchedCopy(nested, 0);
+  const Array<std::string> far = prefetchedCopy(strings, 2 * ROWS);
+  const Array<int> flat = prefetchedCopy(nested[ROWS - 1]);
+
+  bool copied = copy.size() == ROWS && far.size() == ROWS && flat.size() == ROWS - 1 && flat[0] == ROWS - 1;
+  for(size_t row = 0; copied && row < ROWS; ++row)
+    copied = copy[row] == nested[row] && close[row] == nested[row] && (!row || copy[row].data() != nested[row].data())
+             && far[row] == strings[row];
+
+  if(!copied)
+  {
+    std::cout << "prefetched copy test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void numaTest()
+{
+  const size_t SIZE = 1 << 20;
+
+  const Array<int> touched = numaArray<int>(SIZE);
+  const Array<double> interleaved = numaArray<double>(SIZE, NumaPlacement::Interleave, 3);
+  const Array<std::string> strings = numaArray<std::string>(10);
+
+  const bool initialized = std::count(touched.begin(), touched.end(), 0) == static_cast<std::ptrdiff_t>(SIZE)
+                           && std::count(interleaved.begin(), interleaved.end(), 0.0) == static_cast<std::ptrdiff_t>(SIZE)
+                           && strings.size() == 10 && strings[9].empty();
+
+  const unsigned long mask = numaNodeMask();
+  const bool masked = detail::nodeMask("0") == 1 && detail::nodeMask("0,2-3") == 0xd && detail::nodeMask("1-2,5") == 0x26
+                      && detail::nodeMask("0,64") == 0 && (!mask || std::bitset<NUMA_MASK_BITS>(mask).count() == numaNodeCount());
+
+  if(!initialized || !masked || numaNodeCount() < 1 || detail::countNodes("0") != 1 || detail::countNodes("0,2-3") != 3)
+  {
+    std::cout << "numa initialization test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void incrementalCopyTest()
+{
+  const size_t SIZE = 10007;
+  const size_t SLICE = 1000;
+
+  Array<int> source(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+    source[i] = static_cast<int>(i);
+
+  Array<int> target(3);
+  IncrementalCopy<int> copy(target, source, SLICE);
+
+  size_t steps = 1;
+  bool untouched = true;
+  for(; !copy.step(); ++steps)
+    untouched = untouched && target.size() == 3;
+
+  Array<int> kept(5);
+  IncrementalCopy<int> cancelled(kept, source, SLICE);
+  cancelled.step();
+  cancelled.cancel();
+
+  // Foo's assignment throws, so the first slice fails and the target must survive it
+  g_throw_on_constructor = false;
+  Array<Foo> foos(2);
+  foos[1].reset(1);
+  bool thrown = false;
+  {
+    const Array<Foo> other(SIZE);
+    IncrementalCopy<Foo> failing(foos, other, SLICE);
+    try
+    {
+      failing.step();
+    }
+    catch(const std::runtime_error&)
+    {
+      thrown = failing.cancelled() && !failing.step();
+    }
+  }
+
+  if(!untouched || steps != 11 || !copy.committed() || !(target == source) || cancelled.step() || kept.size() != 5
+     || !thrown || foos.size() != 2 || foos[1] != 1)
+  {
+    std::cout << "incremental copy test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void latencyHistogramTest()
+{
+  LatencyHistogram histogram;
+  for(uint64_t value = 1; value <= 1000000; ++value)
+    histogram.record(value);
+  histogram.record(UINT64_MAX);
+
+  LatencyHistogram exact;
+  for(uint64_t value = 0; value < 100; ++value)
+    exact.record(value);
+  histogram.merge(exact);
+
+  // within the 1/64 bucket precision of the true values 500000, 990000 and 999000
+  const uint64_t p50 = histogram.percentile(50);
+  const uint64_t p99 = histogram.percentile(99);
+  const uint64_t p999 = histogram.percentile(99.9);
+
+  if(histogram.count() != 1000101 || histogram.max() != UINT64_MAX || exact.percentile(50) != 49
+     || p50 < 500000 - 8000 || p50 > 500000 + 8000 || p99 < 990000 - 16000 || p99 > 990000 + 16000
+     || p999 < 999000 - 16000 || p999 > 999000 + 16000 || histogram.percentile(100) != UINT64_MAX)
+  {
+    std::cout << "latency histogram test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void baselineTest()
+{
+  BenchmarkResult fast;
+  fast.name = "copy Array<int>";
+  fast.repetitions = 5;
+  fast.samplesMs = {1.0, 1.1, 1.2, 1.3, 1.4};
+  fast.minMs = 1.0;
+  fast.medianMs = 1.2;
+
+  BenchmarkResult latency;
+  latency.name = "push_back latency";
+  latency.repetitions = 1000;
+  latency.percentiles.push_back(std::make_pair(std::string("p50"), 0.25));
+
+  std::stringstream file;
+  writeResults(file, {fast, latency});
+
+  std::vector<BenchmarkResult> baseline;
+  const bool read = readResults(file, baseline);
+
+  BenchmarkResult slow = fast;
+  slow.samplesMs = {1.5, 1.6, 1.7, 1.8, 1.9};
+  slow.minMs = 1.5;
+  slow.medianMs = 1.7;
+
+  // 5 against 5 samples, all slower: 1 of the C(10, 5) = 252 equally likely orderings
+  const double allSlower = slowdownPValue(fast.samplesMs, slow.samplesMs);
+  const double unchanged = slowdownPValue(fast.samplesMs, fast.samplesMs);
+
+  std::stringstream report;
+  std::stringstream garbage("not a results file");
+  std::vector<BenchmarkResult> ignored;
+
+  if(!read || baseline.size() != 2 || baseline[0].name != fast.name || baseline[0].samplesMs != fast.samplesMs
+     || baseline[0].medianMs != fast.medianMs || !baseline[1].samplesMs.empty()
+     || std::abs(allSlower - 1.0 / 252) > 1e-12 || unchanged < 0.5
+     || reportRegressions(report, baseline, {slow}) != 1 || reportRegressions(report, baseline, {slow}, 50) != 0
+     || reportRegressions(report, baseline, {fast}) != 0 || readResults(garbage, ignored))
+  {
+    std::cout << "benchmark baseline test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void traceTest()
+{
+  ArrayTracer::clear();
+
+  ArrayTracer::record<int>(TraceOp::Create, 3);
+  std::thread([]() { ArrayTracer::record<Array<int> >(TraceOp::Copy, 5); }).join();
+  ArrayTracer::record<int>(TraceOp::Destroy, 3);
+
+  std::stringstream trace;
+  const size_t written = ArrayTracer::dumpChromeTrace(trace);
+  const std::string json = trace.str();
+
+  // a second dump finds the rings empty; a full ring drops and counts the rest
+  std::stringstream empty;
+  const size_t rewritten = ArrayTracer::dumpChromeTrace(empty);
+
+  for(size_t i = 0; i < detail::TraceRing::CAPACITY + 5; ++i)
+    ArrayTracer::record<int>(TraceOp::Create, i);
+  std::stringstream full;
+  const size_t kept = ArrayTracer::dumpChromeTrace(full);
+
+  // threads that run one after another take over the ring of the one before, so their events
+  // all land on one track
+  for(size_t t = 0; t < 20; ++t)
+    std::thread([]() { ArrayTracer::record<int>(TraceOp::Create, 1); }).join();
+  std::stringstream sequential;
+  const size_t recorded = ArrayTracer::dumpChromeTrace(sequential);
+  std::set<std::string> tracks;
+  const std::string events = sequential.str();
+  for(size_t at = events.find("\"tid\":"); at != std::string::npos; at = events.find("\"tid\":", at + 1))
+    tracks.insert(events.substr(at, events.find(',', at) - at));
+
+  size_t traced = 0;
+#if ARRAY_TRACE
+  // the hooks in Array: a create, a copy and two destroys, empty Arrays are not traced
+  {
+    Array<int> original(3);
+    Array<int> copy(original);
+    Array<int> none;
+  }
+  std::stringstream hooks;
+  traced = ArrayTracer::dumpChromeTrace(hooks);
+  if(traced != 4 || hooks.str().find("\"name\":\"copy\"") == std::string::npos)
+    traced = 0;
+#else
+  traced = 4;
+#endif
+
+  if(written != 3 || json.find("{\"traceEvents\":[") != 0 || json.find("\"name\":\"copy\"") == std::string::npos
+     || json.find("\"type\":\"Array<int") == std::string::npos || json.find("\"type\":\"int\"") == std::string::npos
+     || json.find("\"dropped\":0") == std::string::npos || rewritten != 0
+     || kept != detail::TraceRing::CAPACITY || full.str().find("\"dropped\":5") == std::string::npos || traced != 4
+     || recorded != 20 || tracks.size() != 1)
+  {
+    std::cout << "trace test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+ARRAY_NOINLINE void allocateSmallArrays()
+{
+  for(size_t i = 0; i < 10000; ++i)
+    Array<int> array(1000, Uninitialized());
+}
+
+ARRAY_NOINLINE void allocateLargeArrays()
+{
+  for(size_t i = 0; i < 100; ++i)
+    Array<double> array(50000, Uninitialized());
+}
+
+void allocationProfileTest()
+{
+#if ARRAY_ALLOCATION_PROFILER
+  // 40 MB in 4000 byte Arrays from one call site, 40 MB in 400 KB Arrays from another
+  AllocationProfiler::start(64 << 10);
+  allocateSmallArrays();
+  allocateLargeArrays();
+  AllocationProfiler::stop();
+  allocateSmallArrays();
+
+  const std::vector<AllocationProfiler::Site> sites = AllocationProfiler::sites();
+  double total = 0;
+  size_t samples = 0;
+  for(size_t s = 0; s < sites.size(); ++s)
+  {
+    total += sites[s].bytes;
+    samples += sites[s].samples;
+  }
+
+  std::stringstream collapsed;
+  const size_t lines = AllocationProfiler::writeCollapsed(collapsed);
+  std::string first;
+  std::getline(collapsed, first);
+
+  // about 700 samples, the estimate is within a few percent; the first slow path of a start()
+  // only rearms the countdown, so one sample short of 80 MB is fine too
+  if(sites.size() < 2 || total < 72e6 || total > 88e6 || samples < 500 || lines != sites.size()
+     || first.find(' ') == std::string::npos)
+  {
+    std::cout << "allocation profile test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+#endif
+}
+
+void compressedTest()
+{
+  const size_t SIZE = 300001;
+
+  // small integers of every transposed width compress, random bits are stored raw
+  std::mt19937_64 random(71);
+  Array<int> counts(SIZE);
+  Array<uint16_t> shorts(SIZE);
+  Array<uint64_t> stamps(SIZE);
+  Array<uint64_t> noise(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+  {
+    counts[i] = static_cast<int>(i % 1000);
+    shorts[i] = static_cast<uint16_t>(i / 4 % 5000);
+    stamps[i] = 1600000000000ull + i / 4;
+    noise[i] = random();
+  }
+
+  const CompressedArray<int> compressedCounts(counts, 2);
+  const CompressedArray<uint16_t> compressedShorts(shorts);
+  const CompressedArray<uint64_t> compressedStamps(stamps);
+  const CompressedArray<uint64_t> compressedNoise(noise);
+  const CompressedArray<int> empty(Array<int>(0));
+
+  bool same = compressedCounts.decompress().size() == SIZE;
+  const Array<int> restored = compressedCounts.decompress();
+  const Array<uint16_t> restoredShorts = compressedShorts.decompress();
+  const Array<uint64_t> restoredStamps = compressedStamps.decompress();
+  const Array<uint64_t> restoredNoise = compressedNoise.decompress();
+  for(size_t i = 0; i < SIZE && same; ++i)
+    same = restored[i] == counts[i] && restoredShorts[i] == shorts[i] && restoredStamps[i] == stamps[i]
+           && restoredNoise[i] == noise[i];
+
+  // a sequential scan decompresses every block once, strided reads across three blocks with
+  // two cache slots decompress one block per read
+  for(size_t i = 0; i < SIZE && same; ++i)
+    same = compressedCounts[i] == counts[i];
+  const size_t scanMisses = compressedCounts.cacheMisses();
+
+  const size_t stride = CompressedArray<int>::BLOCK_ELEMENTS;
+  for(size_t round = 0; round < 4 && same; ++round)
+    for(size_t block = 0; block < 3; ++block)
+      same = compressedCounts[block * stride + round] == counts[block * stride + round];
+  const size_t stridedMisses = compressedCounts.cacheMisses() - scanMisses;
+
+  Array<int> range(3 * stride);
+  compressedCounts.read(stride / 2, range.size(), range.data());
+  for(size_t i = 0; i < range.size() && same; ++i)
+    same = range[i] == counts[stride / 2 + i];
+
+  if(!same || compressedCounts.blocks() != (SIZE + stride - 1) / stride || scanMisses != compressedCounts.blocks()
+     || stridedMisses != 12 || compressedCounts.compressedBytes() * 2 > SIZE * sizeof(int)
+     || compressedShorts.compressedBytes() * 2 > SIZE * sizeof(uint16_t)
+     || compressedStamps.compressedBytes() * 2 > SIZE * sizeof(uint64_t)
+     || compressedNoise.compressedBytes() != SIZE * sizeof(uint64_t) || empty.blocks() || empty.compressedBytes()
+     || empty.decompress().size())
+  {
+    std::cout << "compressed array test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+void frozenTest()
+{
+  const size_t SIZE = 100000;
+
+  Array<int> values(SIZE);
+  for(size_t i = 0; i < SIZE; ++i)
+    values[i] = static_cast<int>(i * 7);
+
+  const uint64_t expectedHash = hashArray(values);
+  const int* elements = values.data();
+
+  // freezing an rvalue takes the elements over, copies of the FrozenArray share them
+  const FrozenArray<int> frozen = freeze(std::move(values));
+  const FrozenArray<int> shared = frozen;
+  const FrozenArray<int> equal = freeze(frozen.thaw());
+  const FrozenArray<int> empty;
+
+  // readers on several threads, no locks
+  std::vector<long long> sums(4, 0);
+  std::vector<std::thread> readers;
+  for(size_t r = 0; r < sums.size(); ++r)
+    readers.push_back(std::thread([&sums, r, shared]()
+    {
+      for(size_t i = 0; i < shared.size(); ++i)
+        sums[r] += shared[i];
+    }));
+  for(size_t r = 0; r < readers.size(); ++r)
+    readers[r].join();
+
+  std::unordered_set<FrozenArray<int> > set;
+  set.insert(frozen);
+  set.insert(equal);
+  set.insert(empty);
+
+  const long long expectedSum = 7LL * SIZE * (SIZE - 1) / 2;
+
+  if(frozen.data() != elements || !shared.shares(frozen) || equal.shares(frozen) || frozen != equal
+     || frozen.hash() != expectedHash || equal.hash() != expectedHash || frozen.size() != SIZE || empty.size()
+     || empty.begin() != empty.end() || empty != freeze(Array<int>()) || frozen == empty || set.size() != 2
+     || sums[0] != expectedSum || sums[3] != expectedSum || frozen.end() - frozen.begin() != static_cast<ptrdiff_t>(SIZE))
+  {
+    std::cout << "frozen array test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+struct SmallPoint
+{
+  short x, y;
+
+  bool operator ==(const SmallPoint& other) const
+  {
+    return x == other.x && y == other.y;
+  }
+};
+
+template<typename T, typename Make>
+bool smallKernelsMatch(Make make)
+{
+  // every size through every size class and past the limit, at an odd offset so that nothing
+  // is aligned
+  for(size_t count = 0; count <= SMALL_KERNEL_LIMIT + 6; ++count)
+  {
+    // the elements around the range stay untouched
+    std::vector<T> filled(count + 3), expected(count + 3);
+    for(size_t i = 0; i < filled.size(); ++i)
+      filled[i] = expected[i] = make(i + 1);
+
+    smallFill(filled.data() + 1, count, make(99));
+    std::fill(expected.begin() + 1, expected.begin() + 1 + count, make(99));
+    if(filled != expected)
+      return false;
+  }
+
+  return true;
+}
+
+void smallKernelTest()
+{
+  const bool ints = smallKernelsMatch<int>([](const size_t i) { return static_cast<int>(i * 31); });
+  const bool doubles = smallKernelsMatch<double>([](const size_t i) { return i * 0.5; });
+  const bool points = smallKernelsMatch<SmallPoint>([](const size_t i)
+  {
+    const SmallPoint point = { static_cast<short>(i), static_cast<short>(i * 3) };
+    return point;
+  });
+
+  // chars through the byte stores of every width
+  const bool chars = smallKernelsMatch<char>([](const size_t i) { return static_cast<char>(i); });
+
+  // and through Array, whose fill takes the small kernels
+  Array<int> array(37);
+  array.fill(9);
+  const bool filled = std::count(array.begin(), array.end(), 9) == 37;
+
+  int fixed[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  int target[8] = {};
+  copyFixed<8>(fixed, target);
+  fillFixed<3>(fixed, 0);
+
+  if(!ints || !doubles || !points || !chars || !filled || !equalFixed<5>(fixed + 3, target + 3)
+     || equalFixed<4>(fixed, target) || target[0] != 1 || fixed[2] || fixed[3] != 4)
+  {
+    std::cout << "small kernel test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+template<typename Iterator>
+bool throwsOutOfRange(const Iterator& iterator)
+{
+  try
+  {
+    const int value = *iterator;
+    (void)value;
+  }
+  catch(const std::out_of_range&)
+  {
+    return true;
+  }
+  return false;
+}
+
+void checkedIteratorTest()
+{
+  const size_t SIZE = 100;
+
+  static_assert(std::is_same<Array<int, NoBoundsCheck>::iterator, int*>::value, "unchecked Arrays iterate with pointers");
+#if defined(NDEBUG)
+  static_assert(std::is_same<Array<int, AssertBoundsCheck>::const_iterator, const int*>::value, "release builds iterate with pointers");
+#endif
+
+  Array<int, ThrowBoundsCheck> values(SIZE);
+  std::iota(values.begin(), values.end(), 0);
+  std::reverse(values.begin(), values.end());
+  std::sort(values.begin(), values.end());
+
+  const Array<int, ThrowBoundsCheck>& constant = values;
+  Array<int, ThrowBoundsCheck>::const_iterator first = values.begin();
+  const bool iterated = std::accumulate(constant.begin(), constant.end(), 0) == static_cast<int>(SIZE * (SIZE - 1) / 2)
+                        && first == constant.begin() && constant.end() - first == static_cast<ptrdiff_t>(SIZE)
+                        && first[SIZE - 1] == static_cast<int>(SIZE - 1) && *(2 + first) == 2 && first < constant.end();
+
+  // stepping out of the range is fine, reading there is not
+  const bool caught = throwsOutOfRange(values.end()) && throwsOutOfRange(values.begin() - 1)
+                      && throwsOutOfRange(constant.begin() + SIZE) && !throwsOutOfRange(values.end() - 1);
+
+  // a sampled iterator lets three of four bad reads through; the range here is shorter than the
+  // memory behind it, so those reads stay inside the buffer
+  int buffer[8] = {};
+  const CheckedIterator<int, SampledBoundsCheck<4> > sampled(buffer, buffer, buffer + 4);
+  size_t sampledThrows = 0;
+  for(size_t i = 4; i < 8; ++i)
+    sampledThrows += throwsOutOfRange(sampled + i);
+
+  if(!iterated || !caught || sampledThrows != 1)
+  {
+    std::cout << "checked iterator test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+// Foo with its allocations served by a pool of its own
+struct PooledFoo : PoolAllocated<PooledFoo>
+{
+  PooledFoo(int data = 5)
+    : m_data(data)
+  {
+    if(g_throw_on_constructor)
+      throw std::runtime_error("operation failed");
+
+    ++g_instance_counter;
+  }
+
+  ~PooledFoo()
+  {
+    --g_instance_counter;
+  }
+
+  int m_data;
+};
+
+// without the instance counter, for the threads
+struct PooledValue : PoolAllocated<PooledValue>
+{
+  PooledValue(int value = 0)
+    : m_value(value)
+  {
+  }
+
+  int m_value;
+};
+
+void objectPoolTest()
+{
+  const size_t ROUNDS = 1000;
+  const size_t THREADS = 4;
+
+  g_throw_on_constructor = false;
+
+  // the blocks of destroyed Arrays are reused, the heap is not asked again
+  const PooledFoo* first = nullptr;
+  {
+    Array<PooledFoo> values(16);
+    first = values.data();
+  }
+  const size_t warmed = ObjectPool<PooledFoo>::heapAllocations();
+
+  bool reused = true;
+  for(size_t round = 0; round < ROUNDS; ++round)
+  {
+    Array<PooledFoo> values(16);
+    Array<PooledFoo> bigger(1 + round % 300, InPlace(), 7);
+    reused = reused && values.data() == first && values[15].m_data == 5 && bigger[bigger.size() - 1].m_data == 7;
+  }
+  const bool noHeap = ObjectPool<PooledFoo>::heapAllocations() - warmed <= POOL_CLASSES;
+
+  // beyond the size classes, a constructor that throws, and single objects
+  Array<PooledFoo> large(POOL_MAX_BLOCK);
+  large[POOL_MAX_BLOCK - 1].m_data = 1;
+
+  g_throw_on_constructor = true;
+  bool thrown = false;
+  try
+  {
+    Array<PooledFoo> failed(10);
+  }
+  catch(const std::runtime_error&)
+  {
+    thrown = true;
+  }
+  g_throw_on_constructor = false;
+
+  std::unique_ptr<PooledFoo> single(new PooledFoo(3));
+
+  // Arrays built on other threads and destroyed on this one, after those threads are gone
+  std::vector<std::vector<Array<PooledValue> > > built(THREADS);
+  std::vector<std::thread> builders;
+  for(size_t t = 0; t < THREADS; ++t)
+    builders.push_back(std::thread([&built, t]()
+    {
+      for(size_t i = 0; i < ROUNDS; ++i)
+      {
+        Array<PooledValue> temporary(1 + i % 100);
+        built[t].push_back(Array<PooledValue>(1 + (i * 7) % 500, InPlace(), static_cast<int>(t)));
+      }
+    }));
+  for(size_t t = 0; t < THREADS; ++t)
+    builders[t].join();
+
+  bool builtRight = true;
+  for(size_t t = 0; t < THREADS; ++t)
+    for(size_t i = 0; i < ROUNDS; ++i)
+      builtRight = builtRight && built[t][i].size() == 1 + (i * 7) % 500 && built[t][i][0].m_value == static_cast<int>(t);
+  built.clear();
+
+  if(!reused || !noHeap || !thrown || !builtRight || large[POOL_MAX_BLOCK - 1].m_data != 1 || single->m_data != 3
+     || g_instance_counter != static_cast<int>(POOL_MAX_BLOCK) + 1)
+  {
+    std::cout << "object pool test failure" << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+}
+
+int main(int argc, char *argv[])
+try
+{
+  logicTest();
+  checkObjectsDestruction();
+
+  safetyTest();
+  checkObjectsDestruction();
+
+  safetyTest(true);
+  checkObjectsDestruction();
+
+  sortTest();
+  mergeTest();
+  permuteTest();
+  histogramTest();
+  hashTest();
+
+  hashMapTest();
+  checkObjectsDestruction();
+
+  slotMapTest();
+  ringTest();
+  jaggedTest();
+
+  moveOnlyTest();
+  checkObjectsDestruction();
+
+  policyTest();
+  checkObjectsDestruction();
+
+  streamTest();
+  prefetchedCopyTest();
+  numaTest();
+
+  incrementalCopyTest();
+  checkObjectsDestruction();
+
+  latencyHistogramTest();
+  baselineTest();
+  traceTest();
+  allocationProfileTest();
+  compressedTest();
+  frozenTest();
+  smallKernelTest();
+  checkedIteratorTest();
+
+  objectPoolTest();
   checkObjectsDestruction();
 
   return EXIT_SUCCESS;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef> // size_t
+#include <exception>
+#include <thread>
+#include <vector>
+
+// number of worker threads the kernels may use (at least one)
+inline size_t hardwareThreads()
+{
+  const unsigned count = std::thread::hardware_concurrency();
+  return count ? count : 1;
+}
+
+// threads worth spawning for 'count' items when each thread should get at least 'grain' of them
+inline size_t parallelThreadCount(const size_t count, const size_t grain)
+{
+  const size_t wanted = grain ? count / grain : count;
+  return std::max<size_t>(1, std::min(wanted, hardwareThreads()));
+}
+
+// 'threads' as the caller of a kernel passed it, 0 leaving the choice to parallelThreadCount
+inline size_t parallelThreadCount(const size_t count, const size_t grain, const size_t threads)
+{
+  return threads ? threads : parallelThreadCount(count, grain);
+}
+
+// first item of the chunk 'index' out of 'threads' equal chunks; chunk 'index' is
+// [partitionBegin(index), partitionBegin(index + 1)), so every kernel that uses the same
+// (count, threads) pair touches the same items from the same thread index
+inline size_t partitionBegin(const size_t count, const size_t threads, const size_t index)
+{
+  return static_cast<size_t>(static_cast<unsigned long long>(count) * index / threads);
+}
+
+// calls f(threadIndex, begin, end) for each chunk, chunk 0 runs on the calling thread;
+// the first exception thrown by any chunk is rethrown after all threads have joined
+template<typename F>
+void parallelFor(const size_t count, const size_t threads, F f)
+{
+  if(threads <= 1)
+  {
+    f(size_t(0), size_t(0), count);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+
+  try
+  {
+    for(size_t t = 1; t < threads; ++t)
+    {
+      const size_t begin = partitionBegin(count, threads, t);
+      const size_t end = partitionBegin(count, threads, t + 1);
+
+      workers.push_back(std::thread([&f, &errors, t, begin, end]()
+      {
+        try
+        {
+          f(t, begin, end);
+        }
+        catch(...)
+        {
+          errors[t] = std::current_exception();
+        }
+      }));
+    }
+
+    f(size_t(0), size_t(0), partitionBegin(count, threads, 1));
+  }
+  catch(...)
+  {
+    // thread creation failed or chunk 0 threw, the started workers must still be joined
+    errors[0] = std::current_exception();
+  }
+
+  for(size_t t = 0; t < workers.size(); ++t)
+    workers[t].join();
+
+  for(size_t t = 0; t < threads; ++t)
+    if(errors[t])
+      std::rethrow_exception(errors[t]);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// hardware counters of the calling thread through perf_event_open. Every event is opened on
+// its own, so an event the CPU or the kernel does not offer only drops that event; when none
+// can be opened (no Linux, perf_event_paranoid, a container without the syscall) available()
+// is false and error() tells why. Events that do not form a group can be multiplexed when
+// there are more of them than hardware counters, so each count is scaled up from the time the
+// event was actually counting to the time it was enabled
+class PerfCounters
+{
+public:
+  PerfCounters()
+  {
+#if defined(__linux__)
+    const uint64_t llcMisses = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                               | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const uint64_t dtlbMisses = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open("llc-misses", PERF_TYPE_HW_CACHE, llcMisses);
+    open("dtlb-misses", PERF_TYPE_HW_CACHE, dtlbMisses);
+    open("branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+    m_error = "perf_event_open needs Linux";
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters()
+  {
+#if defined(__linux__)
+    for(size_t i = 0; i < m_events.size(); ++i)
+      close(m_events[i].fd);
+#endif
+  }
+
+  bool available() const
+  {
+    return !m_events.empty();
+  }
+
+  // why the first event that failed could not be opened, empty when all of them opened
+  const std::string& error() const
+  {
+    return m_error;
+  }
+
+  void start()
+  {
+#if defined(__linux__)
+    for(size_t i = 0; i < m_events.size(); ++i)
+    {
+      ioctl(m_events[i].fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_events[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // counts since start(), by event name; an event that never got a hardware counter counts 0
+  std::vector<std::pair<std::string, uint64_t> > stop()
+  {
+    std::vector<std::pair<std::string, uint64_t> > counts;
+
+#if defined(__linux__)
+    for(size_t i = 0; i < m_events.size(); ++i)
+      ioctl(m_events[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    for(size_t i = 0; i < m_events.size(); ++i)
+    {
+      // value, time enabled, time running
+      uint64_t values[3] = { 0, 0, 0 };
+      if(read(m_events[i].fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+        continue;
+
+      uint64_t value = values[0];
+      if(!values[2])
+        value = 0;
+      else if(values[2] < values[1])
+        value = static_cast<uint64_t>(static_cast<double>(value) * values[1] / values[2]);
+      counts.push_back(std::make_pair(m_events[i].name, value));
+    }
+#endif
+
+    return counts;
+  }
+
+private:
+  struct Event
+  {
+    std::string name;
+    int fd;
+  };
+
+#if defined(__linux__)
+  void open(const char* name, const uint32_t type, const uint64_t config)
+  {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // threads started while counting (parallelFor workers) add their counts when they exit
+    attributes.inherit = 1;
+
+    const long fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+    if(fd < 0)
+    {
+      if(m_error.empty())
+        m_error = std::string(name) + ": " + std::strerror(errno);
+      return;
+    }
+
+    Event event;
+    event.name = name;
+    event.fd = static_cast<int>(fd);
+    m_events.push_back(event);
+  }
+#endif
+
+  std::vector<Event> m_events;
+  std::string m_error;
+};
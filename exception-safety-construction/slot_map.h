@@ -0,0 +1,307 @@
+#pragma once
+
+#include "array.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// stable reference to a SlotMap element; stays valid until that element is erased and is
+// rejected afterwards, even if its slot has been reused
+struct SlotHandle
+{
+  uint32_t index;
+  uint32_t generation;
+
+  bool operator ==(const SlotHandle& other) const
+  {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator !=(const SlotHandle& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+// O(1) insert, erase and lookup with stable handles. Elements live packed in one dense buffer
+// for cache friendly iteration; erase moves the last element into the hole. A slot table maps
+// handles to dense positions and its generation counters (odd while occupied) catch stale handles
+template<typename T>
+class SlotMap
+{
+public:
+  SlotMap()
+    : m_size(0)
+    , m_slotCount(0)
+    , m_freeHead(NO_SLOT)
+  {
+  }
+
+  // copy-constructor
+  SlotMap(const SlotMap& other)
+    : m_elements(other.m_size, Uninitialized())
+    , m_denseToSlot(other.m_denseToSlot)
+    , m_slots(other.m_slots)
+    , m_size(0)
+    , m_slotCount(other.m_slotCount)
+    , m_freeHead(other.m_freeHead)
+  {
+    try
+    {
+      for(; m_size < other.m_size; ++m_size)
+        new (&m_elements[m_size]) T(other.data()[m_size]);
+    }
+    catch(...)
+    {
+      destroyElements();
+      throw;
+    }
+  }
+
+  // move constructor
+  SlotMap(SlotMap&& other) noexcept
+    : SlotMap()
+  {
+    swap(*this, other);
+  }
+
+  SlotMap& operator=(SlotMap other)
+  {
+    swap(*this, other);
+    return *this;
+  }
+
+  ~SlotMap()
+  {
+    destroyElements();
+  }
+
+  void swap(SlotMap& first, SlotMap& second) // nothrow
+  {
+    first.m_elements.swap(first.m_elements, second.m_elements);
+    first.m_denseToSlot.swap(first.m_denseToSlot, second.m_denseToSlot);
+    first.m_slots.swap(first.m_slots, second.m_slots);
+    std::swap(first.m_size, second.m_size);
+    std::swap(first.m_slotCount, second.m_slotCount);
+    std::swap(first.m_freeHead, second.m_freeHead);
+  }
+
+  const size_t size() const
+  {
+    return m_size;
+  }
+
+  bool empty() const
+  {
+    return !m_size;
+  }
+
+  size_t capacity() const
+  {
+    return m_elements.size();
+  }
+
+  void reserve(const size_t count)
+  {
+    if(count > capacity())
+      grow(count);
+  }
+
+  SlotHandle insert(const T& value)
+  {
+    return emplace(value);
+  }
+
+  SlotHandle insert(T&& value)
+  {
+    return emplace(std::move(value));
+  }
+
+  template<typename... Args>
+  SlotHandle emplace(Args&&... args)
+  {
+    if(m_size == capacity())
+    {
+      // 'args' may refer to an element that growing is about to move
+      T value(std::forward<Args>(args)...);
+      grow(std::max(size_t(MIN_CAPACITY), capacity() * 2));
+      return emplaceBack(std::move(value));
+    }
+
+    return emplaceBack(std::forward<Args>(args)...);
+  }
+
+  bool contains(const SlotHandle handle) const
+  {
+    return handle.index < m_slotCount && m_slots[handle.index].generation == handle.generation && (handle.generation & 1);
+  }
+
+  T* find(const SlotHandle handle)
+  {
+    return contains(handle) ? data() + m_slots[handle.index].position : nullptr;
+  }
+
+  const T* find(const SlotHandle handle) const
+  {
+    return contains(handle) ? data() + m_slots[handle.index].position : nullptr;
+  }
+
+  // moves the last element into the erased position, so dense order is not preserved
+  bool erase(const SlotHandle handle)
+  {
+    if(!contains(handle))
+      return false;
+
+    Slot& slot = m_slots[handle.index];
+    const size_t position = slot.position;
+    const size_t last = m_size - 1;
+
+    if(position != last)
+    {
+      data()[position] = std::move(data()[last]);
+      m_denseToSlot[position] = m_denseToSlot[last];
+      m_slots[m_denseToSlot[position]].position = static_cast<uint32_t>(position);
+    }
+
+    data()[last].~T();
+    --m_size;
+
+    ++slot.generation;
+    slot.position = m_freeHead;
+    m_freeHead = handle.index;
+
+    return true;
+  }
+
+  // handle of the element at dense position 'position'
+  SlotHandle handleAt(const size_t position) const
+  {
+    assert(position < m_size);
+
+    const uint32_t index = m_denseToSlot[position];
+    SlotHandle handle = { index, m_slots[index].generation };
+    return handle;
+  }
+
+  T* data()
+  {
+    return reinterpret_cast<T*>(m_elements.data());
+  }
+
+  const T* data() const
+  {
+    return reinterpret_cast<const T*>(m_elements.data());
+  }
+
+  T* begin()
+  {
+    return data();
+  }
+
+  T* end()
+  {
+    return data() + m_size;
+  }
+
+  const T* begin() const
+  {
+    return data();
+  }
+
+  const T* end() const
+  {
+    return data() + m_size;
+  }
+
+private:
+  typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+  // 'position' is the dense index of an occupied slot, or the next free slot of a free one
+  struct Slot
+  {
+    uint32_t position;
+    uint32_t generation;
+  };
+
+  static const uint32_t NO_SLOT = ~uint32_t(0);
+  static const size_t MIN_CAPACITY = 16;
+
+  // the element is constructed before any bookkeeping changes, so a throwing constructor
+  // leaves the map as it was
+  template<typename... Args>
+  SlotHandle emplaceBack(Args&&... args)
+  {
+    assert(m_size < capacity());
+
+    if(m_freeHead == NO_SLOT && m_slotCount == m_slots.size())
+      growSlots();
+
+    new (&m_elements[m_size]) T(std::forward<Args>(args)...);
+
+    uint32_t index = m_freeHead;
+    if(index == NO_SLOT)
+      index = static_cast<uint32_t>(m_slotCount++);
+    else
+      m_freeHead = m_slots[index].position;
+
+    Slot& slot = m_slots[index];
+    slot.position = static_cast<uint32_t>(m_size);
+    ++slot.generation;
+    m_denseToSlot[m_size] = index;
+    ++m_size;
+
+    SlotHandle handle = { index, slot.generation };
+    return handle;
+  }
+
+  // new dense storage is filled before it replaces the old one; elements are moved only when
+  // that cannot throw
+  void grow(const size_t newCapacity)
+  {
+    Array<Storage> elements(newCapacity, Uninitialized());
+    Array<uint32_t> denseToSlot(newCapacity, Uninitialized());
+    T* target = reinterpret_cast<T*>(elements.data());
+    size_t built = 0;
+
+    try
+    {
+      for(; built < m_size; ++built)
+        new (target + built) T(std::move_if_noexcept(data()[built]));
+    }
+    catch(...)
+    {
+      while(built)
+        target[--built].~T();
+      throw;
+    }
+
+    std::copy(m_denseToSlot.begin(), m_denseToSlot.begin() + m_size, denseToSlot.begin());
+    destroyElements();
+    m_elements.swap(m_elements, elements);
+    m_denseToSlot.swap(m_denseToSlot, denseToSlot);
+  }
+
+  void growSlots()
+  {
+    Array<Slot> slots(std::max(size_t(MIN_CAPACITY), m_slots.size() * 2));
+    std::copy(m_slots.begin(), m_slots.begin() + m_slotCount, slots.begin());
+    m_slots.swap(m_slots, slots);
+  }
+
+  // destroys the elements but keeps m_size, the caller resets or replaces the storage
+  void destroyElements()
+  {
+    for(size_t i = 0; i < m_size; ++i)
+      data()[i].~T();
+  }
+
+  Array<Storage> m_elements;
+  Array<uint32_t> m_denseToSlot;
+  Array<Slot> m_slots;
+  size_t m_size;
+  size_t m_slotCount;
+  uint32_t m_freeHead;
+};
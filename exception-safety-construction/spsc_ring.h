@@ -0,0 +1,203 @@
+#pragma once
+
+#include "array.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+const size_t CACHE_LINE_SIZE = 64;
+
+// lock-free ring buffer for exactly one producer thread and one consumer thread. Capacity is a
+// power of two so positions wrap with a mask; head and tail run freely and live on their own
+// cache lines, and each side keeps a private copy of the other side's index that it refreshes
+// only when the ring looks full (producer) or empty (consumer)
+template<typename T>
+class SpscRing
+{
+public:
+  explicit SpscRing(const size_t capacity)
+    : m_capacity(roundUpToPowerOfTwo(capacity))
+    , m_mask(m_capacity - 1)
+    , m_storage(m_capacity * sizeof(T) + CACHE_LINE_SIZE, Uninitialized())
+    , m_items(alignToCacheLine(m_storage.data()))
+    , m_head(0)
+    , m_cachedTail(0)
+    , m_tail(0)
+    , m_cachedHead(0)
+  {
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  ~SpscRing()
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    for(size_t head = m_head.load(std::memory_order_relaxed); head != tail; ++head)
+      item(head)->~T();
+  }
+
+  size_t capacity() const
+  {
+    return m_capacity;
+  }
+
+  // exact only when neither side is running. head is read first: tail can only have moved
+  // further by the time it is read, so the difference never wraps, and a consumer and producer
+  // running in between can only make it overshoot, which the clamp to capacity takes back
+  size_t sizeApprox() const
+  {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    const size_t size = m_tail.load(std::memory_order_acquire) - head;
+    return size < m_capacity ? size : m_capacity;
+  }
+
+  // producer side
+  bool tryPush(const T& value)
+  {
+    return tryEmplace(value);
+  }
+
+  bool tryPush(T&& value)
+  {
+    return tryEmplace(std::move(value));
+  }
+
+  template<typename... Args>
+  bool tryEmplace(Args&&... args)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if(tail - m_cachedHead == m_capacity)
+    {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      if(tail - m_cachedHead == m_capacity)
+        return false;
+    }
+
+    new (item(tail)) T(std::forward<Args>(args)...);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // copies up to 'count' values and publishes them with one store; returns how many fit. If a
+  // copy throws, the values copied before it are still published
+  size_t pushBatch(const T* values, const size_t count)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t space = m_capacity - (tail - m_cachedHead);
+    if(space < count)
+    {
+      m_cachedHead = m_head.load(std::memory_order_acquire);
+      space = m_capacity - (tail - m_cachedHead);
+    }
+
+    const size_t pushed = count < space ? count : space;
+    size_t done = 0;
+
+    try
+    {
+      for(; done < pushed; ++done)
+        new (item(tail + done)) T(values[done]);
+    }
+    catch(...)
+    {
+      m_tail.store(tail + done, std::memory_order_release);
+      throw;
+    }
+
+    m_tail.store(tail + pushed, std::memory_order_release);
+    return pushed;
+  }
+
+  // consumer side
+  bool tryPop(T& value)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if(head == m_cachedTail)
+    {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      if(head == m_cachedTail)
+        return false;
+    }
+
+    T* source = item(head);
+    value = std::move(*source);
+    source->~T();
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // moves up to 'count' values out and releases their slots with one store
+  size_t popBatch(T* values, const size_t count)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    size_t available = m_cachedTail - head;
+    if(available < count)
+    {
+      m_cachedTail = m_tail.load(std::memory_order_acquire);
+      available = m_cachedTail - head;
+    }
+
+    const size_t popped = count < available ? count : available;
+    size_t done = 0;
+
+    try
+    {
+      for(; done < popped; ++done)
+      {
+        T* source = item(head + done);
+        values[done] = std::move(*source);
+        source->~T();
+      }
+    }
+    catch(...)
+    {
+      m_head.store(head + done, std::memory_order_release);
+      throw;
+    }
+
+    m_head.store(head + popped, std::memory_order_release);
+    return popped;
+  }
+
+private:
+  static size_t roundUpToPowerOfTwo(const size_t value)
+  {
+    size_t result = 1;
+    while(result < value)
+      result *= 2;
+    return result;
+  }
+
+  static T* alignToCacheLine(unsigned char* bytes)
+  {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(bytes);
+    return reinterpret_cast<T*>((address + CACHE_LINE_SIZE - 1) & ~uintptr_t(CACHE_LINE_SIZE - 1));
+  }
+
+  T* item(const size_t position) const
+  {
+    return m_items + (position & m_mask);
+  }
+
+  const size_t m_capacity;
+  const size_t m_mask;
+  Array<unsigned char> m_storage;
+  T* const m_items;
+
+  // padding rather than alignas, which plain new, make_shared and containers do not honour
+  // before C++17: a whole cache line between two groups keeps them apart at any address
+  char m_beforeHead[CACHE_LINE_SIZE];
+
+  // consumer owned
+  std::atomic<size_t> m_head;
+  size_t m_cachedTail;
+
+  char m_beforeTail[CACHE_LINE_SIZE];
+
+  // producer owned
+  std::atomic<size_t> m_tail;
+  size_t m_cachedHead;
+};